@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -12,10 +13,15 @@
 #include <unistd.h>
 #include <sstream>
 #include <algorithm>
+#include <limits>
 #include <unordered_set>
+#include <deque>
 #include <functional>
 #include <thread>
+#include <mutex>
+#include <shared_mutex>
 #include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -488,6 +494,59 @@ private:
 
 
 
+/**
+ * Values of `{name}` segments of the route which matched the request. Values are only kept
+ * as positions in the resource so they stay valid when the request is copied and matching
+ * the route never allocates. Names point into the route table of the server.
+ */
+class RouteParams
+{
+public:
+	static constexpr std::size_t MaxParams = 8;
+
+	RouteParams() : _params(), _size(0) {}
+
+	std::size_t size() const { return _size; }
+
+	bool add(std::string_view name, std::size_t offset, std::size_t length)
+	{
+		if (_size == MaxParams)
+			return false;
+
+		_params[_size++] = Param{name, offset, length};
+		return true;
+	}
+
+	void truncate(std::size_t size)
+	{
+		_size = std::min(_size, size);
+	}
+
+	std::optional<std::string_view> get(std::string_view name, std::string_view resource) const
+	{
+		for (std::size_t i = 0; i < _size; ++i)
+		{
+			if (_params[i].name == name)
+				return resource.substr(_params[i].offset, _params[i].length);
+		}
+
+		return std::nullopt;
+	}
+
+private:
+	struct Param
+	{
+		std::string_view name;
+		std::size_t offset;
+		std::size_t length;
+	};
+
+	std::array<Param, MaxParams> _params;
+	std::size_t _size;
+};
+
+
+
 
 
 class HttpRequest : public HttpMessage
@@ -520,6 +579,7 @@ public:
 		, _method(std::forward<Method>(method))
 		, _resource(std::forward<Resource>(resource))
 		, _args(std::forward<Args>(args))
+		, _route_params()
 	{
 	}
 
@@ -537,6 +597,12 @@ public:
 
 	bool has_arg(const std::string& name) const { return _args.has_arg(name); }
 
+	/**
+	 * Returns value of `{name}` segment of the route the request was dispatched to.
+	 */
+	std::optional<std::string_view> get_route_param(std::string_view name) const { return _route_params.get(name, _resource); }
+	void set_route_params(const RouteParams& params) { _route_params = params; }
+
 	virtual std::string dump() const override
 	{
 		std::ostringstream ss;
@@ -553,6 +619,7 @@ private:
 	std::string _method;
 	std::string _resource;
 	UrlArgs _args;
+	RouteParams _route_params;
 };
 
 
@@ -626,6 +693,7 @@ public:
 			{ 415, "Unsupported Media Type" },
 			{ 416, "Requested Range Not Satisfiable" },
 			{ 417, "Expectation Failed" },
+			{ 431, "Request Header Fields Too Large" },
 			{ 500, "Internal Server Error" },
 			{ 501, "Not Implemented" },
 			{ 502, "Bad Gateway" },
@@ -689,6 +757,16 @@ public:
 		_used = std::min(_used + count, get_capacity());
 	}
 
+	/**
+	 * Makes room for more data either by dropping already read data or by growing the buffer.
+	 */
+	void make_writable()
+	{
+		realign();
+		if (get_writable_size() == 0)
+			_buffer.resize(std::max<std::size_t>(_buffer.size() * 2, 4096), 0);
+	}
+
 	std::string_view as_string_view(std::size_t count = 0) const
 	{
 		return std::string_view{_buffer.data() + _read_pos, count == 0 ? get_size() : std::min(count, get_size())};
@@ -816,13 +894,18 @@ enum class ResponseState
 class HttpResponseParser
 {
 public:
-	HttpResponseParser() : _state(detail::ResponseState::Start) {}
+	HttpResponseParser() : _state(detail::ResponseState::Start), _keep_alive(false) {}
 	HttpResponseParser(const HttpResponseParser&) = delete;
 	HttpResponseParser(HttpResponseParser&&) noexcept = default;
 
 	HttpResponseParser& operator=(const HttpResponseParser&) = delete;
 	HttpResponseParser& operator=(HttpResponseParser&&) noexcept = default;
 
+	/**
+	 * Returns whether the server keeps the connection open after the last parsed response.
+	 */
+	bool is_keep_alive() const { return _keep_alive; }
+
 	std::optional<HttpResponse> parse(StringStream& stream)
 	{
 		bool continue_parsing = true;
@@ -895,6 +978,13 @@ public:
 						auto content_type_header = _headers.get_header("content-type");
 						if (content_type_header)
 							_content_type = content_type_header->get_value();
+
+						// HTTP/1.0 servers close the connection unless they say otherwise
+						auto connection_header = _headers.get_header("connection");
+						if (connection_header)
+							_keep_alive = !icase_compare(connection_header->get_value(), std::string{"close"});
+						else
+							_keep_alive = _http_version != "HTTP/1.0";
 					}
 					else if (stream.as_string_view(1) == "\r")
 					{
@@ -932,8 +1022,9 @@ public:
 				}
 				case detail::ResponseState::Content:
 				{
-					auto str = stream.read(_content_length - _content.length());
-					_content += str;
+					// Reading zero bytes would read the whole stream which might already contain next message
+					if (auto remaining = _content_length - _content.length(); remaining > 0)
+						_content += stream.read(remaining);
 					if (_content.length() == _content_length)
 					{
 						_state = detail::ResponseState::Start;
@@ -962,6 +1053,7 @@ private:
 	HttpHeaderTable _headers;
 	std::uint64_t _content_length;
 	std::string _content_type;
+	bool _keep_alive;
 };
 
 
@@ -981,7 +1073,8 @@ struct Network
 
 	static ssize_t write(int fd, const void* buf, size_t len)
 	{
-		return ::send(fd, buf, len, 0);
+		// Peer might close the connection at any time and it should not kill the whole process
+		return ::send(fd, buf, len, MSG_NOSIGNAL);
 	}
 };
 
@@ -1015,7 +1108,7 @@ class Socket
 public:
 	Socket() : Socket(::socket(AF_UNIX, SOCK_STREAM, 0)) {}
 
-	Socket(int fd) : _fd(fd), _stream(4096)
+	Socket(int fd) : _fd(fd), _stream(4096), _max_input_size(std::numeric_limits<std::size_t>::max()), _input_limited(false)
 	{
 		if (_fd < 0)
 			throw SocketError("Unable to create socket");
@@ -1029,7 +1122,7 @@ public:
 		close();
 	}
 
-	Socket(Socket&& rhs) noexcept : _fd(rhs._fd), _stream(std::move(rhs._stream))
+	Socket(Socket&& rhs) noexcept : _fd(rhs._fd), _stream(std::move(rhs._stream)), _max_input_size(rhs._max_input_size), _input_limited(rhs._input_limited)
 	{
 		rhs._fd = 0;
 	}
@@ -1038,6 +1131,8 @@ public:
 	{
 		_fd = rhs._fd;
 		_stream = std::move(rhs._stream);
+		_max_input_size = rhs._max_input_size;
+		_input_limited = rhs._input_limited;
 		rhs._fd = 0;
 		return *this;
 	}
@@ -1049,6 +1144,14 @@ public:
 	StringStream& get_stream() { return _stream; }
 	pollfd get_poll_fd() const { return {_fd, POLLIN, 0}; }
 
+	/**
+	 * Limits the amount of data which was read from the socket but not yet taken out of its stream.
+	 * Once the limit is reached, `read()` stops and `is_input_limited()` reports that there might be
+	 * more data waiting, so the stream needs to be consumed and `read()` called again.
+	 */
+	void set_max_input_size(std::size_t max_input_size) { _max_input_size = max_input_size; }
+	bool is_input_limited() const { return _input_limited; }
+
 	bool is_closed() const { return _fd == 0; }
 
 	bool is_listening() const
@@ -1091,17 +1194,32 @@ public:
 		return client_fd;
 	}
 
-	void read()
+	/**
+	 * Reads everything which is available. Returns `false` if the peer closed the connection.
+	 */
+	bool read()
 	{
 		int n = 0;
+		_input_limited = false;
 
 		do
 		{
-			n = SocketOp::read(_fd, _stream.get_writable_buffer(), _stream.get_writable_size());
+			if (_stream.get_size() >= _max_input_size)
+			{
+				_input_limited = true;
+				return true;
+			}
+
+			// Everything needs to be read out when the socket is watched in edge-triggered mode
+			if (_stream.get_writable_size() == 0)
+				_stream.make_writable();
+
+			auto size = std::min(_stream.get_writable_size(), _max_input_size - _stream.get_size());
+			n = SocketOp::read(_fd, _stream.get_writable_buffer(), size);
 			if (n < 0)
 			{
 				if (errno == EWOULDBLOCK)
-					return;
+					return true;
 
 				throw SocketError("Error while reading data from the local socket");
 			}
@@ -1109,9 +1227,14 @@ public:
 			_stream.increase_used(n);
 		}
 		while (n > 0);
+
+		return false;
 	}
 
-	void write(const std::string& str)
+	/**
+	 * Writes as much as possible without blocking. Returns number of bytes written.
+	 */
+	std::size_t write(std::string_view str)
 	{
 		std::size_t sent = 0;
 		while (sent < str.length())
@@ -1120,13 +1243,15 @@ public:
 			if (n < 0)
 			{
 				if (errno == EWOULDBLOCK)
-					return;
+					break;
 
 				throw SocketError("Error while writing data to the local socket");
 			}
 
 			sent += static_cast<std::size_t>(n);
 		}
+
+		return sent;
 	}
 
 	void close()
@@ -1153,6 +1278,8 @@ private:
 
 	int _fd;
 	StringStream _stream;
+	std::size_t _max_input_size;
+	bool _input_limited;
 };
 
 #define ULOCAL_VERSION "0.3.0"
@@ -1180,7 +1307,7 @@ private:
 class HttpClient
 {
 public:
-	HttpClient(const std::string& local_socket_path, const std::string& host_header = "ulocal " ULOCAL_VERSION) : _local_socket_path(local_socket_path), _host_header(host_header) {}
+	HttpClient(const std::string& local_socket_path, const std::string& host_header = "ulocal " ULOCAL_VERSION) : _local_socket_path(local_socket_path), _host_header(host_header), _connection() {}
 
 	template <typename Method, typename Resource>
 	HttpResponse send_request(Method&& method, Resource&& resource)
@@ -1244,40 +1371,107 @@ public:
 			std::forward<ContentType>(content_type)
 		};
 		request.calculate_content_length();
+		auto data = request.dump();
 
-		Socket<> socket;
-		socket.connect(_local_socket_path);
-		socket.write(request.dump());
+		// Connection is kept open between requests. If the server closed it in the meantime,
+		// it is only noticed once the request is sent so try it again over a new one.
+		auto reused = _connection.has_value();
+		auto response = exchange(data);
+		if (!response && reused)
+			response = exchange(data);
+
+		if (!response)
+			throw RequestError("Server closed connection unexpectedly");
 
+		if (!_connection->response_parser.is_keep_alive())
+			_connection.reset();
+
+		return std::move(response).value();
+	}
+
+	/**
+	 * Closes the connection kept open for the next request.
+	 */
+	void close()
+	{
+		_connection.reset();
+	}
+
+private:
+	struct Connection
+	{
+		Socket<> socket;
 		HttpResponseParser response_parser;
-		std::optional<HttpResponse> maybe_response;
-		auto pollfd = socket.get_poll_fd();
-		bool still_poll = true;
+	};
+
+	/**
+	 * Sends the request and waits for the response. Returns `std::nullopt` if the connection
+	 * was closed before any part of the response arrived.
+	 */
+	std::optional<HttpResponse> exchange(std::string_view data)
+	{
+		if (!_connection)
+		{
+			Connection connection;
+			connection.socket.connect(_local_socket_path);
+			_connection = std::move(connection);
+		}
 
-		while (still_poll && !maybe_response)
+		auto& socket = _connection->socket;
+		pollfd pollfd = {socket.get_fd(), POLLOUT, 0};
+		try
+		{
+			while (!data.empty())
+			{
+				data.remove_prefix(socket.write(data));
+				if (!data.empty() && ::poll(&pollfd, 1, -1) == -1)
+					throw RequestError("Unable to send request to the server");
+			}
+		}
+		catch (const SocketError&)
+		{
+			_connection.reset();
+			return std::nullopt;
+		}
+
+		pollfd.events = POLLIN;
+		bool received = false;
+		while (true)
 		{
 			auto result = ::poll(&pollfd, 1, -1);
 			if (result == -1)
 				throw RequestError("Unable to obtain response from the server");
 
+			bool peer_open = true;
 			if (pollfd.revents & POLLIN)
 			{
-				socket.read();
-				maybe_response = response_parser.parse(socket.get_stream());
+				try
+				{
+					peer_open = socket.read();
+				}
+				catch (const SocketError&)
+				{
+					// Connection reset by the server is the same as if it was closed
+					peer_open = false;
+				}
+
+				received = received || socket.get_stream().get_size() > 0;
+				if (auto response = _connection->response_parser.parse(socket.get_stream()); response)
+					return response;
 			}
 
-			if (pollfd.revents & POLLHUP)
-				still_poll = false;
+			if (!peer_open || (pollfd.revents & (POLLHUP | POLLERR)))
+			{
+				_connection.reset();
+				if (received)
+					throw RequestError("Server closed connection unexpectedly");
+				return std::nullopt;
+			}
 		}
-
-		if (!maybe_response)
-			throw RequestError("Server closed connection unexpectedly");
-
-		return std::move(maybe_response).value();
 	}
 
-private:
 	std::string _local_socket_path, _host_header;
+	std::optional<Connection> _connection;
 };
 
 
@@ -1310,6 +1504,8 @@ public:
 	HttpRequestParser& operator=(const HttpRequestParser&) = delete;
 	HttpRequestParser& operator=(HttpRequestParser&&) noexcept = default;
 
+	bool is_parsing_content() const { return _state == detail::RequestState::Content; }
+
 	std::optional<HttpRequest> parse(StringStream& stream)
 	{
 		bool continue_parsing = true;
@@ -1421,8 +1617,9 @@ public:
 				}
 				case detail::RequestState::Content:
 				{
-					auto str = stream.read(_content_length - _content.length());
-					_content += str;
+					// Reading zero bytes would read the whole stream which might already contain next message
+					if (auto remaining = _content_length - _content.length(); remaining > 0)
+						_content += stream.read(remaining);
 					if (_content.length() == _content_length)
 					{
 						_state = detail::RequestState::Start;
@@ -1455,29 +1652,6 @@ private:
 
 
 
-class HttpConnection
-{
-public:
-	HttpConnection(Socket<>&& socket) : _socket(std::move(socket)), _request_parser() {}
-	HttpConnection(const HttpConnection&) = delete;
-	HttpConnection(HttpConnection&&) noexcept = default;
-
-	HttpConnection& operator=(const HttpConnection&) = delete;
-	HttpConnection& operator=(HttpConnection&&) noexcept = default;
-
-	Socket<>& get_socket() { return _socket; }
-	const Socket<>& get_socket() const { return _socket; }
-	std::optional<HttpRequest> get_request() { return _request_parser.parse(_socket.get_stream()); }
-
-private:
-	Socket<> _socket;
-	HttpRequestParser _request_parser;
-};
-
-
-
-
-
 class Pipe
 {
 public:
@@ -1517,6 +1691,207 @@ private:
 
 
 
+namespace detail {
+
+inline std::string finalize_response(HttpResponse&& response, const std::optional<std::string>& server_header, bool keep_alive)
+{
+	response.calculate_content_length();
+	if (!response.has_header("Content-Length"))
+		response.add_header("Content-Length", 0);
+	if (server_header)
+		response.add_header("Server", server_header.value());
+	response.add_header("Connection", keep_alive ? "keep-alive" : "close");
+	response.add_header("X-Framework", "ulocal " ULOCAL_VERSION);
+	return response.dump();
+}
+
+/**
+ * Response to a single request which might be completed from any thread. Server is woken up
+ * through the pipe if the response is completed after the request callback returned.
+ */
+class PendingResponse
+{
+public:
+	PendingResponse(std::optional<std::string> server_header, bool keep_alive, std::shared_ptr<Pipe> wakeup)
+		: _mutex(), _server_header(std::move(server_header)), _keep_alive(keep_alive), _wakeup(std::move(wakeup)), _data(), _dispatched(false) {}
+
+	void complete(HttpResponse&& response)
+	{
+		auto data = finalize_response(std::move(response), _server_header, _keep_alive);
+
+		std::lock_guard lock(_mutex);
+		if (_data)
+			return;
+
+		_data = std::move(data);
+		if (_dispatched)
+			_wakeup->get_write_socket()->write(std::string_view{"w", 1});
+	}
+
+	/**
+	 * Marks that the request callback returned. Anything completed from now on needs to wake up the server.
+	 */
+	void dispatch()
+	{
+		std::lock_guard lock(_mutex);
+		_dispatched = true;
+	}
+
+	/**
+	 * Returns the response data and whether the connection is kept alive once the response is completed.
+	 */
+	std::optional<std::pair<std::string, bool>> take()
+	{
+		std::lock_guard lock(_mutex);
+		if (!_data)
+			return std::nullopt;
+
+		return std::pair{std::move(_data).value(), _keep_alive};
+	}
+
+private:
+	std::mutex _mutex;
+	std::optional<std::string> _server_header;
+	bool _keep_alive;
+	std::shared_ptr<Pipe> _wakeup;
+	std::optional<std::string> _data;
+	bool _dispatched;
+};
+
+} // namespace detail
+
+/**
+ * Handle through which deferred endpoints send their response. It can be copied and moved
+ * to another thread. Only the first response is sent, every request needs to get one.
+ */
+class HttpResponder
+{
+public:
+	HttpResponder(std::shared_ptr<detail::PendingResponse> pending) : _pending(std::move(pending)) {}
+
+	void send(HttpResponse&& response) const
+	{
+		_pending->complete(std::move(response));
+	}
+
+private:
+	std::shared_ptr<detail::PendingResponse> _pending;
+};
+
+
+
+class HttpConnection
+{
+public:
+	// Largest request which is accepted, larger ones are refused before they are fully received
+	static constexpr std::size_t MaxRequestSize = 64 * 1024;
+
+	HttpConnection(Socket<>&& socket) : _socket(std::move(socket)), _request_parser(), _request_size(0), _responses(), _output(), _closing(false)
+	{
+		_socket.set_max_input_size(MaxRequestSize);
+	}
+
+	HttpConnection(const HttpConnection&) = delete;
+	HttpConnection(HttpConnection&&) noexcept = default;
+
+	HttpConnection& operator=(const HttpConnection&) = delete;
+	HttpConnection& operator=(HttpConnection&&) noexcept = default;
+
+	Socket<>& get_socket() { return _socket; }
+	const Socket<>& get_socket() const { return _socket; }
+
+	/**
+	 * Reads data from the socket. Returns `false` if the peer closed the connection.
+	 */
+	bool read()
+	{
+		auto size = _socket.get_stream().get_size();
+		auto result = _socket.read();
+		_request_size += _socket.get_stream().get_size() - size;
+		return result;
+	}
+
+	std::optional<HttpRequest> get_request()
+	{
+		auto result = _request_parser.parse(_socket.get_stream());
+		// Whatever is left in the stream belongs to the following requests
+		if (result)
+			_request_size = _socket.get_stream().get_size();
+		return result;
+	}
+
+	/**
+	 * Request which is being received is larger than `MaxRequestSize` so it is never going to be accepted.
+	 */
+	bool is_request_too_large() const { return _request_size > MaxRequestSize; }
+	bool is_receiving_content() const { return _request_parser.is_parsing_content(); }
+
+	bool has_pending_output() const { return !_output.empty(); }
+	bool has_pending_responses() const { return !_responses.empty(); }
+
+	/**
+	 * No more requests are read from the connection and it is closed once all responses are sent.
+	 */
+	bool is_closing() const { return _closing; }
+	void close_after_flush() { _closing = true; }
+
+	/**
+	 * Reserves place for the response to the request which was just read. Responses are sent
+	 * in the order of requests even if they are completed in a different order.
+	 */
+	std::shared_ptr<detail::PendingResponse> add_response(std::optional<std::string> server_header, bool keep_alive, std::shared_ptr<Pipe> wakeup)
+	{
+		return _responses.emplace_back(std::make_shared<detail::PendingResponse>(std::move(server_header), keep_alive, std::move(wakeup)));
+	}
+
+	/**
+	 * Moves all completed responses at the front into the output.
+	 */
+	void collect_responses()
+	{
+		while (!_responses.empty())
+		{
+			auto response = _responses.front()->take();
+			if (!response)
+				break;
+
+			_output += response->first;
+			_responses.pop_front();
+
+			if (!response->second)
+			{
+				_responses.clear();
+				_closing = true;
+			}
+		}
+	}
+
+	/**
+	 * Sends as much of the queued data as possible without blocking. The rest is sent
+	 * on the next call once the socket becomes writable again.
+	 */
+	void flush()
+	{
+		if (_output.empty())
+			return;
+
+		auto sent = _socket.write(_output);
+		_output.erase(0, sent);
+	}
+
+private:
+	Socket<> _socket;
+	HttpRequestParser _request_parser;
+	std::size_t _request_size;
+	std::deque<std::shared_ptr<detail::PendingResponse>> _responses;
+	std::string _output;
+	bool _closing;
+};
+
+
+
+
+
 template <typename Callback>
 class Endpoint
 {
@@ -1547,54 +1922,168 @@ private:
 
 
 
+/**
+ * Routes are kept in a trie with one node per path segment so the request is matched against
+ * all of them in a single pass over its resource. Segments written as `{name}` match any
+ * non-empty segment and their values are stored into `RouteParams`. Literal segments take
+ * precedence over parameters. Literal segments and methods are case-insensitive.
+ */
 template <typename Callback>
 class RouteTable
 {
 public:
-	RouteTable() : _table() {}
-
-	bool has_route(const std::string& route) const
+	enum class MatchResult
 	{
-		return _table.find(route) != _table.end();
-	}
+		Found,
+		NoRoute,
+		NoMethod
+	};
 
-	bool has_route_for_method(const std::string& route, const std::string& method) const
+	struct Match
 	{
-		auto route_itr = _table.find(route);
-		if (route_itr == _table.end())
-			return false;
+		MatchResult result;
+		const std::shared_ptr<const Callback>* action;
+	};
 
-		return route_itr->second.find(method) != route_itr->second.end();
-	}
+	RouteTable() : _root() {}
 
-	template <typename R, typename M, typename C>
-	void add_route(R&& route, M&& methods, C&& callback)
+	template <typename M, typename C>
+	void add_route(std::string_view route, const M& methods, C&& callback)
 	{
-		auto itr = _table.find(route);
-		if (itr == _table.end())
-			std::tie(itr, std::ignore) = _table.emplace(route, MethodTable{});
+		auto* node = &_root;
+		for_each_segment(route, [&](std::string_view segment) {
+			node = get_or_add_child(*node, segment);
+		});
 
-		auto& method_table = itr->second;
+		auto action = std::make_shared<const Callback>(std::forward<C>(callback));
 		for (const auto& method : methods)
 		{
-			auto method_itr = method_table.find(method);
-			if (method_itr == method_table.end())
-				method_table.emplace(method, callback);
+			auto itr = std::find_if(node->methods.begin(), node->methods.end(), [&](const auto& entry) {
+				return icase_compare(entry.first, method);
+			});
+			if (itr == node->methods.end())
+				node->methods.emplace_back(method, action);
 			else
-				method_itr->second = callback;
+				itr->second = action;
 		}
 	}
 
-	template <typename... Args>
-	auto perform_action(const std::string& route, const std::string& method, Args&&... args) const
+	Match match(std::string_view route, std::string_view method, RouteParams& params) const
 	{
-		return _table.at(route).at(method)(std::forward<Args>(args)...);
+		// Resource always starts with '/' so the first segment is the empty one before it
+		if (route.empty() || route[0] != '/')
+			return {MatchResult::NoRoute, nullptr};
+
+		return match(_root, route, 1, method, params);
 	}
 
 private:
-	using MethodTable = std::unordered_map<std::string, Callback, CaseInsensitiveHash, CaseInsensitiveCompare>;
+	struct Node
+	{
+		std::string segment;
+		std::vector<std::unique_ptr<Node>> children;
+		std::unique_ptr<Node> param_child;
+		std::vector<std::pair<std::string, std::shared_ptr<const Callback>>> methods;
+	};
+
+	static bool is_param(std::string_view segment)
+	{
+		return segment.size() > 2 && segment.front() == '{' && segment.back() == '}';
+	}
+
+	template <typename Fn>
+	static void for_each_segment(std::string_view route, const Fn& fn)
+	{
+		std::size_t pos = route.empty() || route[0] != '/' ? 0 : 1;
+		while (true)
+		{
+			auto end = std::min(route.find('/', pos), route.size());
+			fn(route.substr(pos, end - pos));
+			if (end == route.size())
+				break;
+			pos = end + 1;
+		}
+	}
+
+	static Node* get_or_add_child(Node& node, std::string_view segment)
+	{
+		if (is_param(segment))
+		{
+			auto name = segment.substr(1, segment.size() - 2);
+			if (!node.param_child)
+			{
+				node.param_child = std::make_unique<Node>();
+				node.param_child->segment = name;
+			}
+			else if (node.param_child->segment != name)
+				throw std::runtime_error("Route parameter '" + std::string{name} + "' conflicts with '" + node.param_child->segment + "'");
+
+			return node.param_child.get();
+		}
+
+		for (auto& child : node.children)
+		{
+			if (icase_compare(child->segment, segment))
+				return child.get();
+		}
+
+		node.children.push_back(std::make_unique<Node>());
+		node.children.back()->segment = segment;
+		return node.children.back().get();
+	}
+
+	static Match match(const Node& node, std::string_view route, std::size_t pos, std::string_view method, RouteParams& params)
+	{
+		if (pos > route.size())
+			return match_method(node, method);
+
+		auto end = std::min(route.find('/', pos), route.size());
+		auto segment = route.substr(pos, end - pos);
+
+		// Matching continues with the parameter if the literal segment leads nowhere
+		auto result = Match{MatchResult::NoRoute, nullptr};
+		for (const auto& child : node.children)
+		{
+			if (icase_compare(child->segment, segment))
+			{
+				result = match(*child, route, end + 1, method, params);
+				break;
+			}
+		}
+
+		if (result.result != MatchResult::Found && node.param_child && !segment.empty())
+		{
+			auto param_count = params.size();
+			if (params.add(node.param_child->segment, pos, segment.size()))
+			{
+				auto param_result = match(*node.param_child, route, end + 1, method, params);
+				if (param_result.result == MatchResult::Found)
+					return param_result;
 
-	std::unordered_map<std::string, MethodTable, CaseInsensitiveHash, CaseInsensitiveCompare> _table;
+				params.truncate(param_count);
+				if (param_result.result == MatchResult::NoMethod)
+					result = param_result;
+			}
+		}
+
+		return result;
+	}
+
+	static Match match_method(const Node& node, std::string_view method)
+	{
+		if (node.methods.empty())
+			return {MatchResult::NoRoute, nullptr};
+
+		for (const auto& [node_method, action] : node.methods)
+		{
+			if (icase_compare(node_method, method))
+				return {MatchResult::Found, &action};
+		}
+
+		return {MatchResult::NoMethod, nullptr};
+	}
+
+	Node _root;
 };
 
 
@@ -1612,18 +2101,41 @@ class HttpServer
 {
 public:
 	using RequestCallback = std::function<HttpResponse(const HttpRequest&)>;
+	using DeferredRequestCallback = std::function<void(const HttpRequest&, const HttpResponder&)>;
+	using FdAddedCallback = std::function<void(int)>;
+	using FdRemovedCallback = std::function<void(int)>;
 
 	HttpServer(const std::string& local_socket_path)
-		: _routes(), _local_socket_path(local_socket_path), _server(), _clients(), _thread(), _control_pipe(), _server_header() {}
+		: _routes(), _routes_mutex(), _local_socket_path(local_socket_path), _server(), _clients(), _deferred_clients(), _thread(), _control_pipe(),
+		_wakeup_pipe(std::make_shared<Pipe>()), _server_header(), _fd_added(), _fd_removed() {}
 	HttpServer(const std::string& local_socket_path, const std::string& server_header) : HttpServer(local_socket_path)
 	{
 		_server_header = server_header;
 	}
 
+	/**
+	 * Registers endpoint for the route. Segments of the route written as `{name}` match any
+	 * segment of the resource and their values are available through `HttpRequest::get_route_param()`.
+	 */
 	template <typename Fn>
 	void endpoint(const std::initializer_list<std::string>& methods, const std::string& route, const Fn& fn)
 	{
-		_routes.add_route(route, methods, fn);
+		deferred_endpoint(methods, route, [fn](const HttpRequest& request, const HttpResponder& responder) {
+			responder.send(fn(request));
+		});
+	}
+
+	/**
+	 * Registers endpoint which does not need to respond before it returns. The response is sent
+	 * whenever `HttpResponder::send()` is called, possibly from another thread, so slow requests
+	 * do not hold up the other connections.
+	 */
+	template <typename Fn>
+	void deferred_endpoint(const std::initializer_list<std::string>& methods, const std::string& route, const Fn& fn)
+	{
+		// Endpoints can be added even while the server is already serving
+		std::unique_lock lock(_routes_mutex);
+		_routes.add_route(route, methods, DeferredRequestCallback{fn});
 	}
 
 	bool is_serving() const
@@ -1631,143 +2143,305 @@ public:
 		return _server.is_listening();
 	}
 
-	void serve()
+	/**
+	 * Lets the server be driven by an external event loop instead of its own thread.
+	 * `added` is called for every file descriptor which needs to be watched for POLLIN
+	 * and POLLOUT and `removed` once it should no longer be watched. Whenever some of them
+	 * is ready, call `handle_fd()`. Needs to be set before calling `listen()`. Descriptors
+	 * need to be watched in edge-triggered mode, they are always read and written until
+	 * they would block.
+	 */
+	void set_fd_notifiers(FdAddedCallback added, FdRemovedCallback removed)
+	{
+		_fd_added = std::move(added);
+		_fd_removed = std::move(removed);
+	}
+
+	/**
+	 * Starts listening without serving the requests on its own thread. Use together with `set_fd_notifiers()`.
+	 */
+	void listen()
 	{
 		_server.listen(_local_socket_path);
+		notify_fd_added(_server.get_fd());
+		notify_fd_added(_wakeup_pipe->get_read_fd());
+	}
 
-		_thread = std::thread([this]() {
+	void handle_fd(int fd, short revents)
+	{
+		if (fd == _server.get_fd())
+		{
+			if (revents & POLLIN)
+				accept_connections();
+			return;
+		}
+		else if (fd == _wakeup_pipe->get_read_fd())
+		{
+			if (revents & POLLIN)
+				send_deferred_responses();
+			return;
+		}
+
+		auto itr = _clients.find(fd);
+		if (itr == _clients.end())
+			return;
+
+		if (!handle_connection(itr->second, revents))
+			close_connection(itr);
+		else if (itr->second.has_pending_responses())
+			_deferred_clients.insert(fd);
+	}
+
+	void serve()
+	{
+		auto epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+		if (epoll_fd < 0)
+			throw SocketError("Unable to create epoll instance");
+
+		auto watch = [epoll_fd](int fd) {
+			epoll_event event = {};
+			event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+			event.data.fd = fd;
+			if (::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+				throw SocketError("Unable to watch file descriptor");
+		};
+
+		set_fd_notifiers(watch, [epoll_fd](int fd) {
+			::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+		});
+		watch(_control_pipe.get_read_fd());
+		listen();
+
+		// Only descriptors which are ready are returned so the cost of each wakeup
+		// does not depend on the number of connected clients
+		_thread = std::thread([this, epoll_fd]() {
+			std::array<epoll_event, 64> events;
 			bool running = true;
 			while (running)
 			{
-				std::vector<pollfd> poll_fds;
-				poll_fds.reserve(_clients.size() + 1);
-				for (const auto& connection : _clients)
-					poll_fds.push_back(connection.get_socket().get_poll_fd());
-				poll_fds.push_back(_server.get_poll_fd());
-				poll_fds.push_back(_control_pipe.get_read_socket()->get_poll_fd());
-
-				auto* server_pollfd = &poll_fds[poll_fds.size() - 2];
-				auto* control_pipe_pollfd = &poll_fds[poll_fds.size() - 1];
-
-				auto result = ::poll(poll_fds.data(), poll_fds.size(), -1);
-				if (result == -1)
-					throw SocketError("Failed while polling HTTP connections");
-				else if (result == 0)
-					continue;
-
-				if (control_pipe_pollfd->revents & POLLIN)
+				auto count = ::epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+				if (count == -1)
 				{
-					_control_pipe.get_read_socket()->read();
-					auto command = _control_pipe.get_read_socket()->get_stream().read_until('\0');
-					if (command.first == "stop")
-						running = false;
+					if (errno == EINTR)
+						continue;
+
+					throw SocketError("Failed while polling HTTP connections");
 				}
 
-				if (server_pollfd->revents & POLLIN)
+				for (int i = 0; i < count; ++i)
 				{
-					auto new_client = _server.accept_connection();
-					while (new_client)
+					auto fd = events[i].data.fd;
+					if (fd == _control_pipe.get_read_fd())
 					{
-						_clients.push_back(std::move(new_client).value());
-						new_client = _server.accept_connection();
+						_control_pipe.get_read_socket()->read();
+						auto command = _control_pipe.get_read_socket()->get_stream().read_until('\0');
+						if (command.first == "stop")
+							running = false;
 					}
+					else
+						handle_fd(fd, static_cast<short>(events[i].events));
 				}
+			}
 
-				std::size_t index = 0;
-				for (auto& connection : _clients)
-				{
-					if (index >= poll_fds.size() - 2)
-						break;
+			::close(epoll_fd);
+		});
+	}
 
-					auto& poll_fd = poll_fds[index];
-					if (poll_fd.revents & POLLIN)
-					{
-						std::optional<HttpResponse> response;
+	void wait_until_done()
+	{
+		_thread.join();
+	}
 
-						try
-						{
-							connection.get_socket().read();
-						}
-						catch (const std::exception& err)
-						{
-							response = HttpResponse{500, err.what()};
-						}
+	void terminate()
+	{
+		_control_pipe.get_write_socket()->write("stop\0");
+	}
 
-						auto maybe_request = connection.get_request();
-						if (maybe_request)
-						{
-							auto request = std::move(maybe_request).value();
-							if (!_routes.has_route(request.get_resource()))
-								response = HttpResponse{404};
-							else if (!_routes.has_route_for_method(request.get_resource(), request.get_method()))
-								response = HttpResponse{405};
-							else
-							{
-								try
-								{
-									response = _routes.perform_action(request.get_resource(), request.get_method(), request);
-								}
-								catch (const std::exception& err)
-								{
-									response = HttpResponse{500, err.what()};
-								}
-							}
-						}
+private:
+	void notify_fd_added(int fd)
+	{
+		if (_fd_added)
+			_fd_added(fd);
+	}
 
-						if (response)
-						{
-							response->calculate_content_length();
-							if (_server_header)
-								response->add_header("Server", _server_header.value());
-							response->add_header("Connection", "close");
-							response->add_header("X-Framework", "ulocal " ULOCAL_VERSION);
-
-							try
-							{
-								connection.get_socket().write(response->dump());
-							}
-							catch (const std::exception& err)
-							{
-								;
-							}
-							connection.get_socket().close();
-						}
-					}
+	void notify_fd_removed(int fd)
+	{
+		if (_fd_removed)
+			_fd_removed(fd);
+	}
 
-					if (poll_fd.revents & POLLHUP)
-						connection.get_socket().close();
+	void close_connection(std::unordered_map<int, HttpConnection>::iterator itr)
+	{
+		// Watching needs to stop before the descriptor is closed and possibly reused
+		notify_fd_removed(itr->first);
+		_deferred_clients.erase(itr->first);
+		_clients.erase(itr);
+	}
 
-					++index;
-				}
+	void send_deferred_responses()
+	{
+		auto& wakeup_socket = *_wakeup_pipe->get_read_socket();
+		wakeup_socket.read();
+		wakeup_socket.get_stream().read();
+		wakeup_socket.get_stream().realign();
 
-				auto remove_itr = std::remove_if(_clients.begin(), _clients.end(), [](const auto& connection) {
-					return connection.get_socket().is_closed();
-				});
-				_clients.erase(remove_itr, _clients.end());
+		for (auto fd_itr = _deferred_clients.begin(); fd_itr != _deferred_clients.end();)
+		{
+			auto itr = _clients.find(*fd_itr);
+			if (itr == _clients.end())
+			{
+				fd_itr = _deferred_clients.erase(fd_itr);
+				continue;
 			}
-		});
+
+			auto& connection = itr->second;
+			if (!send_responses(connection))
+			{
+				notify_fd_removed(itr->first);
+				_clients.erase(itr);
+				fd_itr = _deferred_clients.erase(fd_itr);
+			}
+			else if (!connection.has_pending_responses())
+				fd_itr = _deferred_clients.erase(fd_itr);
+			else
+				++fd_itr;
+		}
 	}
 
-	void wait_until_done()
+	/**
+	 * Sends responses which are already completed. Returns whether the connection should be kept open.
+	 */
+	bool send_responses(HttpConnection& connection)
 	{
-		_thread.join();
+		connection.collect_responses();
+
+		try
+		{
+			connection.flush();
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+
+		return !connection.is_closing() || connection.has_pending_output() || connection.has_pending_responses();
 	}
 
-	void terminate()
+	void accept_connections()
 	{
-		_control_pipe.get_write_socket()->write("stop\0");
+		auto new_client = _server.accept_connection();
+		while (new_client)
+		{
+			auto fd = new_client->get_fd();
+			_clients.emplace(fd, std::move(new_client).value());
+			notify_fd_added(fd);
+			new_client = _server.accept_connection();
+		}
 	}
 
-private:
-	RouteTable<RequestCallback> _routes;
+	/**
+	 * Returns whether the connection should be kept open.
+	 */
+	bool handle_connection(HttpConnection& connection, short revents)
+	{
+		if (revents & POLLIN)
+		{
+			bool peer_open = true;
+			do
+			{
+				try
+				{
+					peer_open = connection.read();
+				}
+				catch (const std::exception& err)
+				{
+					connection.add_response(_server_header, false, _wakeup_pipe)->complete(HttpResponse{500, err.what()});
+					connection.close_after_flush();
+				}
+
+				// Requests can be pipelined so all those which are already complete are answered in order
+				while (!connection.is_closing())
+				{
+					auto maybe_request = connection.get_request();
+					if (!maybe_request)
+						break;
+
+					auto connection_header = maybe_request->get_header("Connection");
+					auto keep_alive = !connection_header || !icase_compare(connection_header->get_value(), std::string{"close"});
+					perform_request(maybe_request.value(), connection.add_response(_server_header, keep_alive, _wakeup_pipe));
+					if (!keep_alive)
+						connection.close_after_flush();
+				}
+
+				if (!connection.is_closing() && connection.is_request_too_large())
+				{
+					connection.add_response(_server_header, false, _wakeup_pipe)->complete(HttpResponse{connection.is_receiving_content() ? 413 : 431});
+					connection.close_after_flush();
+				}
+			}
+			// Reading stopped at the input limit so there might be more data waiting
+			while (!connection.is_closing() && connection.get_socket().is_input_limited());
+
+			// Peer might have only shut down its writing side so it still waits for the responses
+			if (!peer_open)
+				connection.close_after_flush();
+		}
+
+		if (revents & (POLLHUP | POLLERR))
+			return false;
+
+		return send_responses(connection);
+	}
+
+	void perform_request(HttpRequest& request, const std::shared_ptr<detail::PendingResponse>& pending)
+	{
+		HttpResponder responder{pending};
+		std::shared_ptr<const DeferredRequestCallback> action;
+		{
+			RouteParams params;
+			std::shared_lock lock(_routes_mutex);
+			auto match = _routes.match(request.get_resource(), request.get_method(), params);
+			if (match.result == RouteTable<DeferredRequestCallback>::MatchResult::NoRoute)
+				responder.send(HttpResponse{404});
+			else if (match.result == RouteTable<DeferredRequestCallback>::MatchResult::NoMethod)
+				responder.send(HttpResponse{405});
+			else
+			{
+				action = *match.action;
+				request.set_route_params(params);
+			}
+		}
+
+		if (action)
+		{
+			try
+			{
+				(*action)(request, responder);
+			}
+			catch (const std::exception& err)
+			{
+				responder.send(HttpResponse{500, err.what()});
+			}
+		}
+
+		pending->dispatch();
+	}
+
+	RouteTable<DeferredRequestCallback> _routes;
+	mutable std::shared_mutex _routes_mutex;
 	std::string _local_socket_path;
 	Socket<> _server;
-	std::vector<HttpConnection> _clients;
+	std::unordered_map<int, HttpConnection> _clients;
+	std::unordered_set<int> _deferred_clients;
 
 	std::thread _thread;
 	Pipe _control_pipe;
+	std::shared_ptr<Pipe> _wakeup_pipe;
 
 	std::optional<std::string> _server_header;
+
+	FdAddedCallback _fd_added;
+	FdRemovedCallback _fd_removed;
 };
 
 
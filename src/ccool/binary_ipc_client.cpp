@@ -0,0 +1,172 @@
+#include <poll.h>
+
+#include "binary_ipc_client.hpp"
+
+namespace ccool {
+
+namespace {
+
+const char* status_to_string(IpcStatus status)
+{
+	switch (status)
+	{
+		case IpcStatus::Ok:
+			return "Request succeeded";
+		case IpcStatus::InvalidRequest:
+			return "Request is invalid";
+		case IpcStatus::UnknownOperation:
+			return "Operation is not supported by the daemon";
+		case IpcStatus::DeviceNotFound:
+			return "Device not found";
+		case IpcStatus::DeviceDetached:
+			return "Device is detached";
+		case IpcStatus::Failed:
+			return "Request failed";
+	}
+
+	return "Unknown status";
+}
+
+void wait_for(const ulocal::Socket<>& socket, short events)
+{
+	pollfd pollfd = {socket.get_fd(), events, 0};
+	if (::poll(&pollfd, 1, -1) == -1)
+		throw ulocal::SocketError("Unable to wait for the binary IPC socket");
+}
+
+} // namespace
+
+BinaryIpcError::BinaryIpcError(IpcStatus status) : std::runtime_error(status_to_string(status)), _status(status)
+{
+}
+
+BinaryIpcClient::BinaryIpcClient(const std::string& socket_path) : _socket_path(socket_path), _socket(), _next_tag(0)
+{
+}
+
+IpcStatusResponse BinaryIpcClient::read_status(std::uint16_t device_id, std::uint32_t max_age)
+{
+	return exchange<IpcStatusResponse>(IpcOperation::ReadStatus, device_id, IpcReadRequest{max_age});
+}
+
+IpcPumpResponse BinaryIpcClient::read_pump(std::uint16_t device_id, std::uint32_t max_age)
+{
+	return exchange<IpcPumpResponse>(IpcOperation::ReadPump, device_id, IpcReadRequest{max_age});
+}
+
+IpcFansResponse BinaryIpcClient::read_fans(std::uint16_t device_id, std::uint32_t max_age)
+{
+	return exchange<IpcFansResponse>(IpcOperation::ReadFans, device_id, IpcReadRequest{max_age});
+}
+
+IpcTemperatureResponse BinaryIpcClient::read_temperature(std::uint16_t device_id, std::uint32_t max_age)
+{
+	return exchange<IpcTemperatureResponse>(IpcOperation::ReadTemperature, device_id, IpcReadRequest{max_age});
+}
+
+IpcFirmwareResponse BinaryIpcClient::read_firmware(std::uint16_t device_id)
+{
+	return exchange<IpcFirmwareResponse>(IpcOperation::ReadFirmware, device_id);
+}
+
+void BinaryIpcClient::write_pump_mode(std::uint16_t device_id, std::uint8_t mode)
+{
+	exchange<IpcEmptyPayload>(IpcOperation::WritePumpMode, device_id, IpcWritePumpModeRequest{mode});
+}
+
+void BinaryIpcClient::write_fans_pwm(std::uint16_t device_id, std::uint8_t pwm)
+{
+	exchange<IpcEmptyPayload>(IpcOperation::WriteFansPwm, device_id, IpcWriteFansPwmRequest{pwm});
+}
+
+void BinaryIpcClient::write_fans_rpm(std::uint16_t device_id, std::uint16_t rpm)
+{
+	exchange<IpcEmptyPayload>(IpcOperation::WriteFansRpm, device_id, IpcWriteFansRpmRequest{rpm});
+}
+
+void BinaryIpcClient::write_fans_curve(std::uint16_t device_id, const IpcWriteFansCurveRequest& curve)
+{
+	exchange<IpcEmptyPayload>(IpcOperation::WriteFansCurve, device_id, curve);
+}
+
+void BinaryIpcClient::close()
+{
+	_socket.reset();
+}
+
+template <typename Response, typename Request>
+Response BinaryIpcClient::exchange(IpcOperation operation, std::uint16_t device_id, const Request& request)
+{
+	auto tag = _next_tag++;
+	auto message = exchange_message(encode_ipc_message(IpcRequestHeader{0, tag, operation, device_id}, request));
+
+	auto header = decode_ipc<IpcResponseHeader>(std::string_view{message}.substr(0, sizeof(IpcResponseHeader))).value();
+	if (header.tag != tag || header.operation != operation)
+	{
+		close();
+		throw std::runtime_error("Binary IPC response does not belong to the request");
+	}
+
+	if (header.status != IpcStatus::Ok)
+		throw BinaryIpcError(header.status);
+
+	auto response = decode_ipc<Response>(std::string_view{message}.substr(sizeof(IpcResponseHeader)));
+	if (!response)
+		throw std::runtime_error("Binary IPC response has unexpected size");
+
+	return response.value();
+}
+
+std::string BinaryIpcClient::exchange_message(const std::string& message)
+{
+	try
+	{
+		if (!_socket)
+		{
+			_socket.emplace();
+			_socket->connect(_socket_path);
+		}
+
+		auto data = std::string_view{message};
+		while (!data.empty())
+		{
+			data.remove_prefix(_socket->write(data));
+			if (!data.empty())
+				wait_for(_socket.value(), POLLOUT);
+		}
+
+		auto& stream = _socket->get_stream();
+		auto open = true;
+		while (true)
+		{
+			if (stream.get_size() >= sizeof(IpcResponseHeader))
+			{
+				auto header = decode_ipc<IpcResponseHeader>(stream.as_string_view(sizeof(IpcResponseHeader))).value();
+				if (header.length < sizeof(IpcResponseHeader) || header.length > IpcMaxMessageSize)
+					throw ulocal::SocketError("Binary IPC response has invalid length");
+
+				if (stream.get_size() >= header.length)
+				{
+					auto response = std::string{stream.read(header.length)};
+					if (!open)
+						close();
+					return response;
+				}
+			}
+
+			if (!open)
+				throw ulocal::SocketError("Daemon closed the binary IPC connection");
+
+			wait_for(_socket.value(), POLLIN);
+			open = _socket->read();
+		}
+	}
+	catch (const ulocal::SocketError&)
+	{
+		// Next request starts with a new connection
+		close();
+		throw;
+	}
+}
+
+} // namespace ccool
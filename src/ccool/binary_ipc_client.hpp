@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#include <ulocal/ulocal.hpp>
+
+#include <binary_ipc.hpp>
+
+namespace ccool {
+
+class BinaryIpcError : public std::runtime_error
+{
+public:
+	BinaryIpcError(IpcStatus status);
+
+	IpcStatus get_status() const { return _status; }
+
+private:
+	IpcStatus _status;
+};
+
+/**
+ * Client of the binary IPC of the daemon. Connection is opened with the first request
+ * and kept open for the following ones. Requests are sent one at a time and the calls
+ * block until the response arrives. Failed operations throw `BinaryIpcError`.
+ */
+class BinaryIpcClient
+{
+public:
+	BinaryIpcClient(const std::string& socket_path);
+
+	IpcStatusResponse read_status(std::uint16_t device_id, std::uint32_t max_age = IpcDefaultMaxAge);
+	IpcPumpResponse read_pump(std::uint16_t device_id, std::uint32_t max_age = IpcDefaultMaxAge);
+	IpcFansResponse read_fans(std::uint16_t device_id, std::uint32_t max_age = IpcDefaultMaxAge);
+	IpcTemperatureResponse read_temperature(std::uint16_t device_id, std::uint32_t max_age = IpcDefaultMaxAge);
+	IpcFirmwareResponse read_firmware(std::uint16_t device_id);
+
+	void write_pump_mode(std::uint16_t device_id, std::uint8_t mode);
+	void write_fans_pwm(std::uint16_t device_id, std::uint8_t pwm);
+	void write_fans_rpm(std::uint16_t device_id, std::uint16_t rpm);
+	void write_fans_curve(std::uint16_t device_id, const IpcWriteFansCurveRequest& curve);
+
+	void close();
+
+private:
+	template <typename Response, typename Request = IpcEmptyPayload>
+	Response exchange(IpcOperation operation, std::uint16_t device_id, const Request& request = {});
+
+	std::string exchange_message(const std::string& message);
+
+	std::string _socket_path;
+	std::optional<ulocal::Socket<>> _socket;
+	std::uint32_t _next_tag;
+};
+
+} // namespace ccool
@@ -10,6 +10,8 @@
 #include <conversion.hpp>
 #include <string.hpp>
 
+#include "binary_ipc_client.hpp"
+
 void print_data(bool show_json, const nlohmann::json& json)
 {
 	if (show_json)
@@ -47,10 +49,106 @@ ulocal::HttpResponse send_request(ulocal::HttpClient& client, const std::string&
 	return {};
 }
 
+/**
+ * Parses points of the fan curve from `fans curve <TEMP>-<PWM>...` command.
+ */
+std::optional<std::vector<std::pair<std::uint8_t, std::uint8_t>>> parse_fans_curve(const std::vector<std::string>& commands)
+{
+	std::vector<std::pair<std::uint8_t, std::uint8_t>> result;
+	for (auto itr = commands.begin() + 2; itr != commands.end(); ++itr)
+	{
+		auto temp_pwm = ccool::split(*itr, '-');
+		if (temp_pwm.size() != 2)
+			return std::nullopt;
+
+		result.emplace_back(ccool::convert<std::uint8_t>(temp_pwm[0]).value(), ccool::convert<std::uint8_t>(temp_pwm[1]).value());
+	}
+
+	return result;
+}
+
+/**
+ * Performs the command over the binary IPC. Output is the same as if it was done over HTTP.
+ * Returns std::nullopt for commands which have no binary counterpart.
+ */
+std::optional<nlohmann::json> run_binary_command(ccool::BinaryIpcClient& client, std::uint16_t device_id, const std::vector<std::string>& commands)
+{
+	auto fans_rpm_to_json = [](auto fan_count, const auto& rpm) {
+		return std::vector<std::uint16_t>(rpm.begin(), rpm.begin() + fan_count);
+	};
+
+	if (commands[0] == "status")
+	{
+		auto status = client.read_status(device_id);
+		return nlohmann::json{
+			{"pump", {{"rpm", status.pump_rpm}}},
+			{"fans", {{"rpm", fans_rpm_to_json(status.fan_count, status.fans_rpm)}}},
+			{"temperature", status.temperature / 1000.0}
+		};
+	}
+	else if (commands[0] == "pump")
+	{
+		if (commands.size() == 1)
+			return nlohmann::json{{"rpm", client.read_pump(device_id).rpm}};
+
+		client.write_pump_mode(device_id, ccool::convert<std::uint8_t>(commands[1]).value());
+		return nlohmann::json::object();
+	}
+	else if (commands[0] == "fans")
+	{
+		if (commands.size() == 1)
+		{
+			auto fans = client.read_fans(device_id);
+			return nlohmann::json{{"rpm", fans_rpm_to_json(fans.fan_count, fans.rpm)}};
+		}
+
+		if (commands[1] == "pwm")
+			client.write_fans_pwm(device_id, ccool::convert<std::uint8_t>(commands[2]).value());
+		else if (commands[1] == "rpm")
+			client.write_fans_rpm(device_id, ccool::convert<std::uint16_t>(commands[2]).value());
+		else if (commands[1] == "curve")
+		{
+			auto curve_points = parse_fans_curve(commands);
+			if (!curve_points || curve_points->size() > ccool::IpcMaxCurvePoints)
+				return std::nullopt;
+
+			ccool::IpcWriteFansCurveRequest curve = {};
+			for (const auto& [temperature, pwm] : curve_points.value())
+			{
+				curve.temperatures[curve.size] = temperature;
+				curve.pwms[curve.size] = pwm;
+				++curve.size;
+			}
+			client.write_fans_curve(device_id, curve);
+		}
+		else
+			return std::nullopt;
+
+		return nlohmann::json::object();
+	}
+	else if (commands[0] == "temp")
+		return nlohmann::json{{"temperature", client.read_temperature(device_id).temperature / 1000.0}};
+	else if (commands[0] == "firmware")
+	{
+		auto version = client.read_firmware(device_id);
+		return nlohmann::json{
+			{"version", {
+				{"major", version.major},
+				{"minor", version.minor},
+				{"patch", version.patch}
+			}}
+		};
+	}
+
+	return std::nullopt;
+}
+
 int main(int argc, char* argv[])
 {
 	cxxopts::Options options("ccool", "CCool CLI client");
 	options.add_options()
+		("b,binary-socket", "Use binary IPC on specified socket for commands which support it", cxxopts::value<std::string>())
+		("d,device", "ID of the device to use (first device is used if not specified)", cxxopts::value<std::uint32_t>())
 		("h,help", "Show usage")
 		("j,json", "Show raw output in form of JSON")
 		("s,socket", "Use specified socket", cxxopts::value<std::string>()->default_value("/var/run/ccool/ccoold.sock"))
@@ -74,63 +172,106 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
+	if (result.count("binary-socket"))
+	{
+		ccool::BinaryIpcClient binary_client(result["binary-socket"].as<std::string>());
+		auto device_id = result.count("device") ? result["device"].as<std::uint32_t>() : 0u;
+		try
+		{
+			// Commands without binary counterpart continue over HTTP
+			if (auto response_data = run_binary_command(binary_client, static_cast<std::uint16_t>(device_id), commands); response_data)
+			{
+				print_data(json_output, response_data.value());
+				return 0;
+			}
+		}
+		catch (const ccool::BinaryIpcError& error)
+		{
+			fmt::print(stderr, "Request failed!\n\n{}\n", error.what());
+			return 2;
+		}
+	}
+
 	ulocal::HttpClient client(result["socket"].as<std::string>());
 	ulocal::HttpResponse response;
 
-	if (commands[0] == "info")
-		response = send_request(client, "GET", "/info");
+	auto device_prefix = std::string{};
+	if (result.count("device"))
+		device_prefix = fmt::format("/devices/{}", result["device"].as<std::uint32_t>());
+
+	if (commands[0] == "devices")
+		response = send_request(client, "GET", "/devices");
+	else if (commands[0] == "info")
+		response = send_request(client, "GET", device_prefix + "/info");
 	else if (commands[0] == "pump")
 	{
 		if (commands.size() == 1)
-			response = send_request(client, "GET", "/pump");
+			response = send_request(client, "GET", device_prefix + "/pump");
 		else
-			response = send_request(client, "POST", "/pump", nlohmann::json{
+			response = send_request(client, "POST", device_prefix + "/pump", nlohmann::json{
 				{"mode", ccool::convert<std::uint8_t>(commands[1]).value()}
 			});
 	}
 	else if (commands[0] == "fans")
 	{
 		if (commands.size() == 1)
-			response = send_request(client, "GET", "/fans");
+			response = send_request(client, "GET", device_prefix + "/fans");
 		else
 		{
 			if (commands[1] == "pwm")
-				response = send_request(client, "POST", "/fans", nlohmann::json{
+				response = send_request(client, "POST", device_prefix + "/fans", nlohmann::json{
 					{"pwm", ccool::convert<std::uint8_t>(commands[2]).value()}
 				});
 			else if (commands[1] == "rpm")
-				response = send_request(client, "POST", "/fans", nlohmann::json{
+				response = send_request(client, "POST", device_prefix + "/fans", nlohmann::json{
 					{"rpm", ccool::convert<std::uint16_t>(commands[2]).value()}
 				});
 			else if (commands[1] == "curve")
 			{
-				commands.erase(commands.begin(), commands.begin() + 2);
-				auto curve_points = nlohmann::json::array();
-				for (const auto& command : commands)
+				auto points = parse_fans_curve(commands);
+				if (!points)
 				{
-					auto temp_pwm = ccool::split(command, '-');
-					if (temp_pwm.size() != 2)
-					{
-						fmt::print(stderr, "Fan curve needs to specified in format <TEMP>-<PWM>\n");
-						return 1;
-					}
+					fmt::print(stderr, "Fan curve needs to specified in format <TEMP>-<PWM>\n");
+					return 1;
+				}
 
+				auto curve_points = nlohmann::json::array();
+				for (const auto& [temperature, pwm] : points.value())
+				{
 					curve_points.push_back(nlohmann::json{
-						{"temperature", ccool::convert<std::uint8_t>(temp_pwm[0]).value()},
-						{"pwm", ccool::convert<std::uint8_t>(temp_pwm[1]).value()}
+						{"temperature", temperature},
+						{"pwm", pwm}
 					});
 				}
 
-				response = send_request(client, "POST", "/fans", nlohmann::json{
+				response = send_request(client, "POST", device_prefix + "/fans", nlohmann::json{
 					{"curve", curve_points}
 				});
 			}
 		}
 	}
 	else if (commands[0] == "temp")
-		response = send_request(client, "GET", "/temperature");
+		response = send_request(client, "GET", device_prefix + "/temperature");
+	else if (commands[0] == "status")
+		response = send_request(client, "GET", device_prefix + "/status");
+	else if (commands[0] == "history")
+	{
+		if (commands.size() < 2)
+		{
+			fmt::print(stderr, "History needs to be specified in format <SENSOR> [FROM] [STEP]\n");
+			return 1;
+		}
+
+		auto resource = fmt::format("{}/history?sensor={}", device_prefix, commands[1]);
+		if (commands.size() > 2)
+			resource += fmt::format("&from={}", commands[2]);
+		if (commands.size() > 3)
+			resource += fmt::format("&step={}", commands[3]);
+
+		response = send_request(client, "GET", resource);
+	}
 	else if (commands[0] == "firmware")
-		response = send_request(client, "GET", "/firmware");
+		response = send_request(client, "GET", device_prefix + "/firmware");
 	else
 	{
 		fmt::print(stderr, "Unknown command: {}", commands[0]);
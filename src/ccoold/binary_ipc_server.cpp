@@ -0,0 +1,176 @@
+#include <sys/epoll.h>
+
+#include <spdlog/spdlog.h>
+
+#include "binary_ipc_server.hpp"
+#include "logging.hpp"
+
+namespace ccool {
+
+BinaryIpcResponder::BinaryIpcResponder(BinaryIpcServer* server, int fd, std::uint64_t connection_id, const IpcRequestHeader& request)
+	: _server(server), _fd(fd), _connection_id(connection_id), _tag(request.tag), _operation(request.operation)
+{
+}
+
+void BinaryIpcResponder::send_error(IpcStatus status) const
+{
+	send_message(encode_ipc_message(IpcResponseHeader{0, _tag, _operation, status}));
+}
+
+void BinaryIpcResponder::send_message(std::string&& message) const
+{
+	_server->queue_response(_fd, _connection_id, std::move(message));
+}
+
+BinaryIpcServer::BinaryIpcServer(EventLoop& event_loop, const std::string& socket_path, RequestCallback callback)
+	: _event_loop(event_loop), _socket_path(socket_path), _callback(std::move(callback)), _server(), _connections(), _next_connection_id(0)
+{
+}
+
+BinaryIpcServer::~BinaryIpcServer()
+{
+	for (const auto& [fd, connection] : _connections)
+		_event_loop.remove_fd(fd);
+
+	if (_server.is_listening())
+		_event_loop.remove_fd(_server.get_fd());
+}
+
+void BinaryIpcServer::listen()
+{
+	_server.listen(_socket_path);
+	_event_loop.add_fd(_server.get_fd(), EPOLLIN | EPOLLET, [this](std::uint32_t) {
+		accept_connections();
+	});
+}
+
+void BinaryIpcServer::accept_connections()
+{
+	try
+	{
+		while (auto socket = _server.accept_connection())
+		{
+			auto fd = socket->get_fd();
+			// No message is longer than this so there is no need to buffer more of them at once
+			socket->set_max_input_size(IpcMaxMessageSize);
+			_connections.emplace(fd, Connection{_next_connection_id++, std::move(socket).value(), std::string{}, 0, false});
+			_event_loop.add_fd(fd, EPOLLIN | EPOLLOUT | EPOLLET, [this, fd](std::uint32_t events) {
+				handle_connection(fd, events);
+			});
+		}
+	}
+	catch (const ulocal::SocketError& err)
+	{
+		LOG->error("Binary IPC server is unable to accept connection: {}", err.what());
+	}
+}
+
+void BinaryIpcServer::handle_connection(int fd, std::uint32_t events)
+{
+	auto itr = _connections.find(fd);
+	if (itr == _connections.end())
+		return;
+
+	auto& connection = itr->second;
+	try
+	{
+		if (events & EPOLLOUT)
+			flush(connection);
+
+		if (!connection.closing && (events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+		{
+			bool open = true;
+			do
+			{
+				open = connection.socket.read();
+				if (!read_requests(fd, connection))
+				{
+					close_connection(fd);
+					return;
+				}
+			}
+			// Reading stopped at the input limit so there might be more data waiting
+			while (connection.socket.is_input_limited());
+
+			// Peer might have only shut down its writing side so it still waits for the responses
+			if (!open)
+				connection.closing = true;
+		}
+
+		if (is_finished(connection))
+			close_connection(fd);
+	}
+	catch (const ulocal::SocketError&)
+	{
+		close_connection(fd);
+	}
+}
+
+bool BinaryIpcServer::read_requests(int fd, Connection& connection)
+{
+	auto& stream = connection.socket.get_stream();
+	while (stream.get_size() >= sizeof(IpcRequestHeader))
+	{
+		auto header = decode_ipc<IpcRequestHeader>(stream.as_string_view(sizeof(IpcRequestHeader))).value();
+		if (header.length < sizeof(IpcRequestHeader) || header.length > IpcMaxMessageSize)
+		{
+			LOG->warn("Binary IPC server received message of invalid length {}", header.length);
+			return false;
+		}
+
+		if (stream.get_size() < header.length)
+			break;
+
+		auto message = stream.read(header.length);
+		++connection.pending_responses;
+		_callback(header, message.substr(sizeof(IpcRequestHeader)), BinaryIpcResponder{this, fd, connection.id, header});
+	}
+
+	return true;
+}
+
+void BinaryIpcServer::flush(Connection& connection)
+{
+	if (connection.output.empty())
+		return;
+
+	auto sent = connection.socket.write(connection.output);
+	connection.output.erase(0, sent);
+}
+
+bool BinaryIpcServer::is_finished(const Connection& connection) const
+{
+	return connection.closing && connection.pending_responses == 0 && connection.output.empty();
+}
+
+void BinaryIpcServer::close_connection(int fd)
+{
+	_event_loop.remove_fd(fd);
+	_connections.erase(fd);
+}
+
+void BinaryIpcServer::queue_response(int fd, std::uint64_t connection_id, std::string&& message)
+{
+	// Connections are only ever touched by the event loop
+	_event_loop.post([this, fd, connection_id, message = std::move(message)]() {
+		auto itr = _connections.find(fd);
+		// Descriptor of closed connection can be already reused by another one
+		if (itr == _connections.end() || itr->second.id != connection_id)
+			return;
+
+		try
+		{
+			--itr->second.pending_responses;
+			itr->second.output += message;
+			flush(itr->second);
+			if (is_finished(itr->second))
+				close_connection(fd);
+		}
+		catch (const ulocal::SocketError&)
+		{
+			close_connection(fd);
+		}
+	});
+}
+
+} // namespace ccool
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <ulocal/ulocal.hpp>
+
+#include <binary_ipc.hpp>
+
+#include "event_loop.hpp"
+
+namespace ccool {
+
+class BinaryIpcServer;
+
+/**
+ * Sends response to single request of the binary IPC. It can be copied and used from any
+ * thread. Response is dropped if the connection was closed in the meantime.
+ */
+class BinaryIpcResponder
+{
+public:
+	BinaryIpcResponder(BinaryIpcServer* server, int fd, std::uint64_t connection_id, const IpcRequestHeader& request);
+
+	template <typename Payload = IpcEmptyPayload>
+	void send(const Payload& payload = {}) const
+	{
+		send_message(encode_ipc_message(IpcResponseHeader{0, _tag, _operation, IpcStatus::Ok}, payload));
+	}
+
+	void send_error(IpcStatus status) const;
+
+private:
+	void send_message(std::string&& message) const;
+
+	BinaryIpcServer* _server;
+	int _fd;
+	std::uint64_t _connection_id;
+	std::uint32_t _tag;
+	IpcOperation _operation;
+};
+
+/**
+ * Server of the binary IPC (see `binary_ipc.hpp`) driven by the event loop. Requests are
+ * passed to the callback on the thread running the loop. Payload is only valid during
+ * the call but the response can be sent at any time later.
+ */
+class BinaryIpcServer
+{
+public:
+	using RequestCallback = std::function<void(const IpcRequestHeader& header, std::string_view payload, const BinaryIpcResponder& responder)>;
+
+	BinaryIpcServer(EventLoop& event_loop, const std::string& socket_path, RequestCallback callback);
+	BinaryIpcServer(const BinaryIpcServer&) = delete;
+	BinaryIpcServer(BinaryIpcServer&&) noexcept = delete;
+	~BinaryIpcServer();
+
+	BinaryIpcServer& operator=(const BinaryIpcServer&) = delete;
+	BinaryIpcServer& operator=(BinaryIpcServer&&) noexcept = delete;
+
+	void listen();
+
+private:
+	friend class BinaryIpcResponder;
+
+	struct Connection
+	{
+		std::uint64_t id;
+		ulocal::Socket<> socket;
+		std::string output;
+		// Requests which were read but not yet answered
+		std::size_t pending_responses;
+		// Peer does not send any more requests, connection is closed once all responses are sent
+		bool closing;
+	};
+
+	void accept_connections();
+	void handle_connection(int fd, std::uint32_t events);
+	bool read_requests(int fd, Connection& connection);
+	void flush(Connection& connection);
+	bool is_finished(const Connection& connection) const;
+	void close_connection(int fd);
+	void queue_response(int fd, std::uint64_t connection_id, std::string&& message);
+
+	EventLoop& _event_loop;
+	std::string _socket_path;
+	RequestCallback _callback;
+	ulocal::Socket<> _server;
+	std::unordered_map<int, Connection> _connections;
+	std::uint64_t _next_connection_id;
+};
+
+} // namespace ccool
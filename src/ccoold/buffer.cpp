@@ -1,111 +1,187 @@
-#include <cctype>
-#include <stdexcept>
+#include <algorithm>
+#include <utility>
 
 #include "buffer.hpp"
+#include "buffer_pool.hpp"
+#include "hex.hpp"
 
 namespace ccool {
 
-namespace {
+BytesView operator "" _bv(const char* bytes, std::size_t size)
+{
+	return {reinterpret_cast<const std::uint8_t*>(bytes), size};
+}
 
-inline char byte_to_hex_char(std::uint8_t byte)
+Buffer::Buffer() : _write_pos(0), _read_pos(0), _size(0), _capacity(InlineCapacity), _heap_data(), _pool()
 {
-	byte = byte & 0x0F;
-	if (byte <= 9)
-		return byte + '0';
-	else
-		return byte - 10 + 'a';
 }
 
-inline std::uint8_t hex_char_to_nibble(char hex_char)
+Buffer::Buffer(std::unique_ptr<std::uint8_t[]>&& heap_data, std::size_t capacity, std::shared_ptr<BufferPool>&& pool)
+	: _write_pos(0), _read_pos(0), _size(0), _capacity(capacity), _heap_data(std::move(heap_data)), _pool(std::move(pool))
 {
-	hex_char = std::tolower(hex_char);
-	if ('0' <= hex_char && hex_char <= '9')
-		return hex_char - '0';
-	else if ('a' <= hex_char && hex_char <= 'f')
-		return hex_char - 'a' + 10;
-	else
-		throw std::runtime_error("Invalid hex char when converting to bytes");
 }
 
-inline std::uint8_t hex_chars_to_byte(char high_char, char low_char)
+Buffer::Buffer(BytesView data) : Buffer(data.data(), data.size())
 {
-	return (hex_char_to_nibble(high_char) << 4) | hex_char_to_nibble(low_char);
 }
 
+Buffer::Buffer(std::size_t size) : Buffer()
+{
+	resize(size);
+	_write_pos = size;
 }
 
-BytesView operator "" _bv(const char* bytes, std::size_t size)
+Buffer::Buffer(const std::uint8_t* data, std::size_t size) : Buffer()
 {
-	return {reinterpret_cast<const std::uint8_t*>(bytes), size};
+	assign(data, size);
+	_write_pos = size;
 }
 
-Buffer::Buffer()  : _write_pos(0), _read_pos(0), _data()
+Buffer::Buffer(std::vector<std::uint8_t>&& data) : Buffer(data.data(), data.size())
 {
 }
 
-Buffer::Buffer(BytesView data) : _write_pos(data.end() - data.begin()), _read_pos(0), _data(data.begin(), data.end())
+Buffer::Buffer(const std::string& hex_string) : Buffer()
 {
+	assign_hex_string(hex_string);
 }
 
-Buffer::Buffer(std::size_t size) : _write_pos(size), _read_pos(0), _data(size, 0)
+Buffer::Buffer(const Buffer& rhs) : Buffer()
 {
+	*this = rhs;
 }
 
-Buffer::Buffer(const std::uint8_t* data, std::size_t size) : _write_pos(size), _read_pos(0), _data(data, data + size)
+Buffer::Buffer(Buffer&& rhs) noexcept : Buffer()
 {
+	*this = std::move(rhs);
 }
 
-Buffer::Buffer(std::vector<std::uint8_t>&& data) : _write_pos(data.size()), _read_pos(0), _data(std::move(data))
+Buffer::~Buffer()
 {
+	release_heap_data();
 }
 
-Buffer::Buffer(const std::string& hex_string) : _write_pos(0), _read_pos(0), _data()
+Buffer& Buffer::operator=(const Buffer& rhs)
 {
-	_data.reserve(hex_string.size() / 2);
-	for (std::size_t i = 0; i < (hex_string.size() & ~1); i += 2)
-		_data.push_back(hex_chars_to_byte(hex_string[i], hex_string[i + 1]));
-	_write_pos = _data.size();
+	if (this != &rhs)
+	{
+		assign(rhs.get_raw_data(), rhs._size);
+		_write_pos = rhs._write_pos;
+		_read_pos = rhs._read_pos;
+	}
+
+	return *this;
+}
+
+Buffer& Buffer::operator=(Buffer&& rhs) noexcept
+{
+	if (this == &rhs)
+		return *this;
+
+	if (rhs._heap_data)
+	{
+		release_heap_data();
+		_heap_data = std::move(rhs._heap_data);
+		_pool = std::move(rhs._pool);
+		_capacity = rhs._capacity;
+		_size = rhs._size;
+	}
+	else
+	{
+		// Inline data can't be stolen, only copied, but they always fit into our storage
+		std::memcpy(get_raw_data(), rhs._inline_data, rhs._size);
+		_size = rhs._size;
+	}
+
+	_write_pos = std::exchange(rhs._write_pos, 0);
+	_read_pos = std::exchange(rhs._read_pos, 0);
+	rhs._size = 0;
+	rhs._capacity = InlineCapacity;
+	return *this;
 }
 
 std::uint8_t* Buffer::get_raw_data()
 {
-	return _data.data();
+	return _heap_data ? _heap_data.get() : _inline_data;
 }
 
 const std::uint8_t* Buffer::get_raw_data() const
 {
-	return _data.data();
+	return _heap_data ? _heap_data.get() : _inline_data;
 }
 
 BytesView Buffer::get_data() const
 {
-	return {_data.data(), _data.size()};
+	return {get_raw_data(), _size};
 }
 
 std::size_t Buffer::get_size() const
 {
-	return _data.size();
+	return _size;
+}
+
+std::size_t Buffer::get_capacity() const
+{
+	return _capacity;
 }
 
 void Buffer::resize(std::size_t new_size)
 {
-	_data.resize(new_size, 0);
+	if (new_size > _capacity)
+		reallocate(std::max(new_size, 2 * _capacity));
+
+	if (new_size > _size)
+		std::memset(get_raw_data() + _size, 0, new_size - _size);
+
+	_size = new_size;
+}
+
+void Buffer::assign_hex_string(const std::string& hex_string)
+{
+	_size = 0;
+	resize(hex_string.size() / 2);
+	hex_decode(hex_string.data(), _size, get_raw_data());
+	_write_pos = _size;
+	_read_pos = 0;
+}
+
+void Buffer::reallocate(std::size_t capacity)
+{
+	auto new_data = std::make_unique_for_overwrite<std::uint8_t[]>(capacity);
+	std::memcpy(new_data.get(), get_raw_data(), _size);
+	release_heap_data();
+	_heap_data = std::move(new_data);
+	_capacity = capacity;
+}
+
+void Buffer::release_heap_data()
+{
+	if (_heap_data && _pool)
+		_pool->recycle(std::move(_heap_data), _capacity);
+
+	_heap_data.reset();
+	_pool.reset();
+	_capacity = InlineCapacity;
+}
+
+void Buffer::assign(const std::uint8_t* data, std::size_t size)
+{
+	_size = 0;
+	resize(size);
+	if (size > 0)
+		std::memcpy(get_raw_data(), data, size);
 }
 
 std::string Buffer::get_hex_string() const
 {
 	std::string result(get_size() * 2, '\0');
-	for (std::size_t i = 0; i < get_size(); ++i)
-	{
-		result[2*i] = byte_to_hex_char(_data[i] >> 4);
-		result[2*i + 1] = byte_to_hex_char(_data[i]);
-	}
+	hex_encode(get_raw_data(), get_size(), result.data());
 	return result;
 }
 
 bool Buffer::operator==(const Buffer& rhs) const
 {
-	return _data == rhs._data;
+	return get_data() == rhs.get_data();
 }
 
 bool Buffer::operator!=(const Buffer& rhs) const
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -15,36 +19,48 @@ using BytesView = std::basic_string_view<std::uint8_t>;
 
 BytesView operator "" _bv(const char* bytes, std::size_t size);
 
+class BufferPool;
+
+/**
+ * Byte buffer used for messages exchanged with the device. Messages are at most
+ * one endpoint MTU long so up to `InlineCapacity` bytes are stored inline in the buffer
+ * itself and only larger payloads are stored on the heap. Heap storage grows geometrically.
+ */
 class Buffer
 {
 public:
+	static constexpr std::size_t InlineCapacity = 64;
+
 	Buffer();
 	Buffer(BytesView data);
 	Buffer(std::size_t size);
 	Buffer(const std::uint8_t* data, std::size_t size);
 	Buffer(std::vector<std::uint8_t>&& data);
 	Buffer(const std::string& hex_string);
-	Buffer(const Buffer&) = default;
-	Buffer(Buffer&&) noexcept = default;
+	Buffer(const Buffer& rhs);
+	Buffer(Buffer&& rhs) noexcept;
+	~Buffer();
 
-	Buffer& operator=(const Buffer&) = default;
-	Buffer& operator=(Buffer&&) noexcept = default;
+	Buffer& operator=(const Buffer& rhs);
+	Buffer& operator=(Buffer&& rhs) noexcept;
 
 	std::uint8_t* get_raw_data();
 	const std::uint8_t* get_raw_data() const;
 	BytesView get_data() const;
 	std::size_t get_size() const;
+	std::size_t get_capacity() const;
 
 	void resize(std::size_t new_size);
+	void assign_hex_string(const std::string& hex_string);
 
 	template <Endian E, typename T>
 	std::enable_if_t<std::is_integral_v<T>, void> write(T value)
 	{
-		if (_write_pos + sizeof(T) >= _data.size())
-			_data.resize(_data.size() + sizeof(T));
+		if (_write_pos + sizeof(T) > _size)
+			resize(_write_pos + sizeof(T));
 
 		auto value_ce = endian_convert<Endian::Native, E>(value);
-		std::memcpy(_data.data() + _write_pos, reinterpret_cast<std::uint8_t*>(&value_ce), sizeof(T));
+		std::memcpy(get_raw_data() + _write_pos, reinterpret_cast<std::uint8_t*>(&value_ce), sizeof(T));
 		_write_pos += sizeof(T);
 	}
 
@@ -57,27 +73,63 @@ public:
 	template <Endian E, typename T, typename InnerT = typename T::value_type>
 	void write(const T& values)
 	{
-		for (auto&& value : values)
-			write<E, typename T::value_type>(value);
+		if constexpr (std::is_integral_v<InnerT> && std::ranges::contiguous_range<T>)
+			write_array<E, InnerT>(std::span<const InnerT>{values});
+		else
+		{
+			for (auto&& value : values)
+				write<E, InnerT>(value);
+		}
+	}
+
+	/**
+	 * Writes all values at once. Values are copied as a whole and then byte-swapped
+	 * in a single pass if the endianness differs.
+	 */
+	template <Endian E, typename T>
+	std::enable_if_t<std::is_integral_v<T>, void> write_array(std::span<const T> values)
+	{
+		auto size = values.size_bytes();
+		if (_write_pos + size > _size)
+			resize(_write_pos + size);
+
+		auto* data = get_raw_data() + _write_pos;
+		if constexpr (sizeof(T) == 1 || E == Endian::Native)
+		{
+			if (size > 0)
+				std::memcpy(data, values.data(), size);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < values.size(); ++i)
+			{
+				auto value_ce = endian_convert<Endian::Native, E>(values[i]);
+				std::memcpy(data + i * sizeof(T), &value_ce, sizeof(T));
+			}
+		}
+
+		_write_pos += size;
 	}
 
 	void write_nt_string(std::string_view str)
 	{
-		if (_write_pos >= _data.size())
-			_data.resize(_data.size() + str.size() + 1);
+		if (_write_pos + str.size() + 1 > _size)
+			resize(_write_pos + str.size() + 1);
 
-		std::strcpy(reinterpret_cast<char*>(_data.data()) + _write_pos, str.data());
+		auto* data = get_raw_data() + _write_pos;
+		std::memcpy(data, str.data(), str.size());
+		data[str.size()] = '\0';
 		_write_pos += str.size() + 1;
 	}
 
 	template <Endian E, typename T>
 	std::enable_if_t<std::is_integral_v<T>, std::optional<T>> read() const
 	{
-		if (_read_pos + sizeof(T) > _data.size())
+		if (_read_pos + sizeof(T) > _size)
 			return std::nullopt;
 
 		T result;
-		std::memcpy(reinterpret_cast<std::uint8_t*>(&result), _data.data() + _read_pos, sizeof(T));
+		std::memcpy(reinterpret_cast<std::uint8_t*>(&result), get_raw_data() + _read_pos, sizeof(T));
 		_read_pos += sizeof(T);
 		return endian_convert<E, Endian::Native>(result);
 	}
@@ -96,24 +148,64 @@ public:
 	std::enable_if_t<std::is_same_v<T, std::vector<InnerT>>, std::optional<T>> read(std::size_t count) const
 	{
 		T result;
-		result.reserve(count);
-
-		for (std::size_t i = 0; i < count; ++i)
+		if constexpr (std::is_integral_v<InnerT>)
 		{
-			if (auto value = read<E, InnerT>(); value.has_value())
-				result.push_back(std::move(value.value()));
+			// Only whole values which are still available are read
+			result.resize(std::min(count, (_size - std::min(_read_pos, _size)) / sizeof(InnerT)));
+			read_array<E, InnerT>(std::span<InnerT>{result});
+		}
+		else
+		{
+			result.reserve(count);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (auto value = read<E, InnerT>(); value.has_value())
+					result.push_back(std::move(value.value()));
+			}
 		}
 
 		return result;
 	}
 
+	/**
+	 * Reads as many values as fits into `values` at once. Returns false and reads nothing
+	 * if there is not enough data.
+	 */
+	template <Endian E, typename T>
+	std::enable_if_t<std::is_integral_v<T>, bool> read_array(std::span<T> values) const
+	{
+		auto size = values.size_bytes();
+		if (_read_pos + size > _size)
+			return false;
+
+		const auto* data = get_raw_data() + _read_pos;
+		if constexpr (sizeof(T) == 1 || E == Endian::Native)
+		{
+			if (size > 0)
+				std::memcpy(values.data(), data, size);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < values.size(); ++i)
+			{
+				T value;
+				std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+				values[i] = endian_convert<E, Endian::Native>(value);
+			}
+		}
+
+		_read_pos += size;
+		return true;
+	}
+
 	std::optional<std::string_view> read_nt_string() const
 	{
 		auto pos = _read_pos;
-		while (pos < _data.size())
+		const auto* data = get_raw_data();
+		while (pos < _size)
 		{
-			if (_data[pos++] == '\0')
-				return std::string_view{reinterpret_cast<const char*>(_data.data()) + _read_pos};
+			if (data[pos++] == '\0')
+				return std::string_view{reinterpret_cast<const char*>(data) + _read_pos};
 		}
 
 		_read_pos = pos;
@@ -126,8 +218,20 @@ public:
 	bool operator!=(const Buffer& rhs) const;
 
 private:
+	friend class BufferPool;
+
+	Buffer(std::unique_ptr<std::uint8_t[]>&& heap_data, std::size_t capacity, std::shared_ptr<BufferPool>&& pool);
+
+	void assign(const std::uint8_t* data, std::size_t size);
+	void reallocate(std::size_t capacity);
+	void release_heap_data();
+
 	mutable std::size_t _write_pos, _read_pos;
-	std::vector<std::uint8_t> _data;
+	std::size_t _size;
+	std::size_t _capacity;
+	std::unique_ptr<std::uint8_t[]> _heap_data;
+	std::shared_ptr<BufferPool> _pool; ///< Pool which gets the heap storage back
+	std::uint8_t _inline_data[InlineCapacity];
 };
 
 } // namespace ccool
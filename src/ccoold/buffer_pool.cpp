@@ -0,0 +1,70 @@
+#include <algorithm>
+
+#include "buffer_pool.hpp"
+
+namespace ccool {
+
+BufferPool::BufferPool() : _mutex(), _free_blocks(), _acquired(0), _inlined(0), _hits(0), _allocations(0)
+{
+	_free_blocks.reserve(MaxFreeBlocks);
+}
+
+Buffer BufferPool::acquire(std::size_t size)
+{
+	++_acquired;
+
+	Buffer result;
+	if (size > Buffer::InlineCapacity)
+	{
+		Block block{};
+		{
+			std::lock_guard lock(_mutex);
+			auto itr = std::find_if(_free_blocks.begin(), _free_blocks.end(), [size](const auto& block) {
+				return block.capacity >= size;
+			});
+			if (itr != _free_blocks.end())
+			{
+				block = std::move(*itr);
+				_free_blocks.erase(itr);
+			}
+		}
+
+		if (!block.data)
+		{
+			block = Block{std::make_unique_for_overwrite<std::uint8_t[]>(size), size};
+			++_allocations;
+		}
+		else
+			++_hits;
+
+		result = Buffer(std::move(block.data), block.capacity, shared_from_this());
+	}
+	else
+		++_inlined;
+
+	result.resize(size);
+	result._write_pos = size;
+	return result;
+}
+
+Buffer BufferPool::acquire(BytesView data)
+{
+	auto result = acquire(data.size());
+	if (!data.empty())
+		std::memcpy(result.get_raw_data(), data.data(), data.size());
+	return result;
+}
+
+BufferPoolStats BufferPool::get_stats() const
+{
+	return {_acquired, _inlined, _hits, _allocations};
+}
+
+void BufferPool::recycle(std::unique_ptr<std::uint8_t[]>&& data, std::size_t capacity)
+{
+	std::lock_guard lock(_mutex);
+	if (_free_blocks.size() < MaxFreeBlocks)
+		_free_blocks.push_back(Block{std::move(data), capacity});
+}
+
+} // namespace ccool
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "buffer.hpp"
+
+namespace ccool {
+
+/**
+ * Only buffers larger than `Buffer::InlineCapacity` go to the pool. Each of them is either a hit,
+ * which reuses free block, or an allocation. Smaller buffers are counted as inlined.
+ */
+struct BufferPoolStats
+{
+	std::uint64_t acquired;
+	std::uint64_t inlined;
+	std::uint64_t hits;
+	std::uint64_t allocations;
+};
+
+/**
+ * Pool of heap storage for buffers which do not fit into the inline storage of `Buffer`.
+ * Buffers acquired from the pool give their storage back once they are destroyed, no matter
+ * which thread does it, so steady traffic of messages of the same size does not allocate.
+ * Pool needs to be owned by `std::shared_ptr` since the buffers keep it alive.
+ */
+class BufferPool : public std::enable_shared_from_this<BufferPool>
+{
+public:
+	static constexpr std::size_t MaxFreeBlocks = 16;
+
+	BufferPool();
+	BufferPool(const BufferPool&) = delete;
+	BufferPool(BufferPool&&) noexcept = delete;
+
+	BufferPool& operator=(const BufferPool&) = delete;
+	BufferPool& operator=(BufferPool&&) noexcept = delete;
+
+	/**
+	 * Returns zeroed buffer of the given size.
+	 */
+	Buffer acquire(std::size_t size);
+
+	/**
+	 * Returns buffer holding copy of `data`.
+	 */
+	Buffer acquire(BytesView data);
+
+	BufferPoolStats get_stats() const;
+
+private:
+	friend class Buffer;
+
+	struct Block
+	{
+		std::unique_ptr<std::uint8_t[]> data;
+		std::size_t capacity;
+	};
+
+	void recycle(std::unique_ptr<std::uint8_t[]>&& data, std::size_t capacity);
+
+	std::mutex _mutex;
+	std::vector<Block> _free_blocks;
+	std::atomic<std::uint64_t> _acquired;
+	std::atomic<std::uint64_t> _inlined;
+	std::atomic<std::uint64_t> _hits;
+	std::atomic<std::uint64_t> _allocations;
+};
+
+} // namespace ccool
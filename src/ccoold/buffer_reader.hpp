@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "buffer.hpp"
+#include "endian.hpp"
+#include "fixed_point.hpp"
+
+namespace ccool {
+
+/**
+ * Cursor over data which were already checked to be large enough for everything that
+ * is going to be read from them. Reads do no bounds checking at all, so use `Buffer::read`
+ * for data of unknown size. Field getters of generated message layouts are built on it.
+ */
+template <Endian E>
+class BufferReader
+{
+public:
+	BufferReader(BytesView data) : _pos(data.data()) {}
+	BufferReader(const std::uint8_t* data) : _pos(data) {}
+
+	template <typename T>
+	std::enable_if_t<std::is_integral_v<T>, T> read()
+	{
+		T result;
+		std::memcpy(&result, _pos, sizeof(T));
+		_pos += sizeof(T);
+		return endian_convert<E, Endian::Native>(result);
+	}
+
+	template <typename T, std::size_t Width = T::width>
+	std::enable_if_t<std::is_same_v<T, FixedPoint<Width>>, T> read()
+	{
+		return T{read<typename T::UnderlyingType>()};
+	}
+
+	template <typename T>
+	std::enable_if_t<std::is_integral_v<T>, void> read_array(std::span<T> values)
+	{
+		if constexpr (sizeof(T) == 1 || E == Endian::Native)
+		{
+			if (!values.empty())
+				std::memcpy(values.data(), _pos, values.size_bytes());
+		}
+		else
+		{
+			for (std::size_t i = 0; i < values.size(); ++i)
+				values[i] = read<T>();
+			return;
+		}
+
+		_pos += values.size_bytes();
+	}
+
+	void skip(std::size_t size)
+	{
+		_pos += size;
+	}
+
+private:
+	const std::uint8_t* _pos;
+};
+
+} // namespace ccool
@@ -1,88 +1,308 @@
+#include <algorithm>
+#include <cmath>
 #include <csignal>
 #include <filesystem>
-#include <thread>
+#include <functional>
+#include <future>
+#include <mutex>
+
+#include <sys/epoll.h>
 
-#include <fmt/chrono.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/systemd_sink.h>
 #include <ulocal/ulocal.hpp>
 
+#include <conversion.hpp>
+
+#include "binary_ipc_server.hpp"
 #include "ccool_daemon.hpp"
 #include "daemonize.hpp"
 #include "device_detector.hpp"
+#include "event_loop.hpp"
 #include "logging.hpp"
-#include "signals.hpp"
+#include "managed_device.hpp"
+#include "mpsc_queue.hpp"
+#include "telemetry.hpp"
+#include "telemetry_history.hpp"
+#include "worker_pool.hpp"
+
+namespace ccool {
 
-static volatile std::sig_atomic_t quit_requested = 0;
+namespace {
 
-void handle_termination(int/* signum*/)
+// Number of IPC requests which can wait for devices at the same time
+constexpr std::size_t IpcWorkerCount = 4;
+
+static_assert(SensorSnapshot::MaxFans <= IpcMaxFans, "Binary IPC status cannot hold all fans of SensorSnapshot");
+
+/**
+ * Returns maximum age of cached sensor values allowed by the request. Requests
+ * without `max_age` argument (in milliseconds) get `default_max_age`.
+ * Returns std::nullopt if the argument is invalid.
+ */
+std::optional<std::chrono::milliseconds> get_max_age(const ulocal::HttpRequest& request, std::chrono::milliseconds default_max_age)
 {
-	quit_requested = 1;
+	auto max_age_arg = request.get_argument("max_age");
+	if (!max_age_arg)
+		return default_max_age;
+
+	auto max_age = convert<std::uint32_t>(max_age_arg->get_value());
+	if (!max_age)
+		return std::nullopt;
+
+	return std::chrono::milliseconds{max_age.value()};
 }
 
-namespace ccool {
+ulocal::HttpResponse invalid_max_age()
+{
+	return {400, nlohmann::json{
+		{"error", "Argument 'max_age' needs to be number of milliseconds."}
+	}};
+}
 
-CCoolDaemon::CCoolDaemon(const std::string& socket_path, bool daemonize) : _socket_path(socket_path), _daemonize(daemonize)
+nlohmann::json write_stats_to_json(const WriteStats& stats)
 {
+	return {
+		{"issued", stats.issued},
+		{"suppressed", stats.suppressed},
+		{"merged", stats.merged}
+	};
 }
 
-void CCoolDaemon::run(const std::string& interface)
+nlohmann::json buffer_pool_stats_to_json(const BufferPoolStats& stats)
 {
-	using namespace std::literals;
+	return {
+		{"acquired", stats.acquired},
+		{"inlined", stats.inlined},
+		{"hits", stats.hits},
+		{"allocations", stats.allocations}
+	};
+}
 
-	std::shared_ptr<spdlog::logger> logger;
-	if (_daemonize)
-	{
-		daemonize();
-		logger = spdlog::systemd_logger_mt(LOGGER_NAME);
-	}
-	else
-		logger = spdlog::stdout_color_mt(LOGGER_NAME);
+/**
+ * Telemetry of the device which is allowed to be served. Throws `DeviceDetachedError` if the device
+ * is detached so its last readings are never reported as current.
+ */
+TelemetryStore& get_attached_telemetry(ManagedDevice& managed_device)
+{
+	if (!managed_device.is_attached())
+		throw DeviceDetachedError{};
 
-	install_signal_handler(handle_termination, SIGINT, SIGTERM);
-	LOG->set_level(spdlog::level::debug);
-	LOG->error("Test error");
+	return managed_device.get_telemetry();
+}
 
-	DeviceDetector device_detector;
-	auto device = device_detector.detect_device(interface);
-	if (!device)
-	{
-		LOG->info("No device found. Exiting...");
-		return;
-	}
+/**
+ * Sensor values not older than `max_age`, read from the device only if the cached ones are outdated.
+ * Shared by the HTTP endpoints and the binary IPC.
+ */
+std::uint16_t get_pump_rpm(ManagedDevice& managed_device, std::chrono::milliseconds max_age)
+{
+	return get_attached_telemetry(managed_device).pump_rpm.get_or_update(max_age, [&]() {
+		return managed_device.read_pump_rpm().get();
+	});
+}
 
-	std::filesystem::remove(_socket_path);
-	ulocal::HttpServer ipc_server(_socket_path);
+std::vector<std::uint16_t> get_fans_rpm(ManagedDevice& managed_device, std::chrono::milliseconds max_age)
+{
+	return get_attached_telemetry(managed_device).fans_rpm.get_or_update(max_age, [&]() {
+		return managed_device.read_fans_rpm().get();
+	});
+}
+
+FixedPoint<16> get_temperature(ManagedDevice& managed_device, std::chrono::milliseconds max_age)
+{
+	return get_attached_telemetry(managed_device).temperature.get_or_update(max_age, [&]() {
+		return managed_device.read_temperature().get();
+	});
+}
+
+SensorSnapshot get_snapshot(ManagedDevice& managed_device, std::chrono::milliseconds max_age)
+{
+	auto& telemetry = get_attached_telemetry(managed_device);
+	auto pump_rpm = telemetry.pump_rpm.get(max_age);
+	auto fans_rpm = telemetry.fans_rpm.get(max_age);
+	auto temperature = telemetry.temperature.get(max_age);
+	if (!pump_rpm || !fans_rpm || !temperature)
+		return managed_device.read_snapshot().get();
+
+	SensorSnapshot result{pump_rpm.value(), static_cast<std::uint32_t>(std::min(fans_rpm->size(), SensorSnapshot::MaxFans)), {}, temperature.value()};
+	std::copy_n(fans_rpm->begin(), result.fan_count, result.fans_rpm.begin());
+	return result;
+}
+
+/**
+ * Wraps endpoint callback so requests to detached device are answered with 503.
+ */
+template <typename Fn>
+auto with_device_attached(Fn&& fn)
+{
+	return [fn = std::forward<Fn>(fn)](const ulocal::HttpRequest& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		try
+		{
+			return fn(request, managed_device);
+		}
+		catch (const DeviceDetachedError&)
+		{
+			return {503, nlohmann::json{
+				{"error", "Device is detached."}
+			}};
+		}
+	};
+}
+
+using DeviceFinder = std::function<ManagedDevice*(const ulocal::HttpRequest&)>;
+
+/**
+ * Wraps endpoint callback so it gets the device the request is meant for. Requests to
+ * unknown devices are answered with 404.
+ */
+template <typename Fn>
+auto with_device(const DeviceFinder& find_device, Fn&& fn)
+{
+	return [&find_device, fn = std::forward<Fn>(fn)](const ulocal::HttpRequest& request) -> ulocal::HttpResponse {
+		auto* managed_device = find_device(request);
+		if (!managed_device)
+		{
+			return {404, nlohmann::json{
+				{"error", "Device not found."}
+			}};
+		}
 
-	ipc_server.endpoint({"GET"}, "/info", [&](const auto&) -> ulocal::HttpResponse {
-		LOG->debug("IPC server request received - GET /info");
+		return fn(request, *managed_device);
+	};
+}
+
+/**
+ * Turns endpoint callback into a deferred one which runs in the worker pool so the event
+ * loop is free to serve other requests while this one waits for the device.
+ */
+template <typename Fn>
+auto on_worker_pool(WorkerPool& workers, Fn&& fn)
+{
+	return [&workers, fn = std::forward<Fn>(fn)](const ulocal::HttpRequest& request, const ulocal::HttpResponder& responder) {
+		workers.submit([fn, request, responder]() {
+			try
+			{
+				responder.send(fn(request));
+			}
+			catch (const std::exception& err)
+			{
+				responder.send(ulocal::HttpResponse{500, err.what()});
+			}
+		});
+	};
+}
+
+/**
+ * Registers endpoints operating on a single device under the given prefix. The device
+ * is looked up for each request using `find_device`.
+ */
+void register_device_endpoints(ulocal::HttpServer& ipc_server, WorkerPool& workers, const std::string& prefix, const DeviceFinder& find_device, std::chrono::milliseconds default_max_age)
+{
+	ipc_server.endpoint({"GET"}, prefix + "/info", with_device(find_device, [](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		LOG->debug("IPC server request received - GET {}", request.get_resource());
 		return nlohmann::json{
-			{"name", device->get_name()},
-			{"fan_count", device->get_fan_count()}
+			{"name", managed_device.get_name()},
+			{"fan_count", managed_device.get_fan_count()},
+			{"attached", managed_device.is_attached()},
+			{"writes", {
+				{"pump", write_stats_to_json(managed_device.get_pump_write_stats())},
+				{"fans", write_stats_to_json(managed_device.get_fans_write_stats())}
+			}},
+			{"buffer_pool", buffer_pool_stats_to_json(managed_device.get_buffer_pool_stats())}
 		};
-	});
-	ipc_server.endpoint({"GET"}, "/pump", [&](const auto&) -> ulocal::HttpResponse {
-		LOG->debug("IPC server request received - GET /pump");
+	}));
+	ipc_server.deferred_endpoint({"GET"}, prefix + "/pump", on_worker_pool(workers, with_device(find_device, with_device_attached([default_max_age](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		LOG->debug("IPC server request received - GET {}", request.get_resource());
+		auto max_age = get_max_age(request, default_max_age);
+		if (!max_age)
+			return invalid_max_age();
+
 		return nlohmann::json{
-			{"rpm", device->read_pump_rpm()}
+			{"rpm", get_pump_rpm(managed_device, max_age.value())}
 		};
-	});
-	ipc_server.endpoint({"GET"}, "/fans", [&](const auto&) -> ulocal::HttpResponse {
-		LOG->debug("IPC server request received - GET /fans");
+	}))));
+	ipc_server.deferred_endpoint({"GET"}, prefix + "/fans", on_worker_pool(workers, with_device(find_device, with_device_attached([default_max_age](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		LOG->debug("IPC server request received - GET {}", request.get_resource());
+		auto max_age = get_max_age(request, default_max_age);
+		if (!max_age)
+			return invalid_max_age();
+
 		return nlohmann::json{
-			{"rpm", device->read_fans_rpm()}
+			{"rpm", get_fans_rpm(managed_device, max_age.value())}
 		};
-	});
-	ipc_server.endpoint({"GET"}, "/temperature", [&](const auto&) -> ulocal::HttpResponse {
-		LOG->debug("IPC server request received - GET /temperature");
+	}))));
+	ipc_server.deferred_endpoint({"GET"}, prefix + "/temperature", on_worker_pool(workers, with_device(find_device, with_device_attached([default_max_age](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		LOG->debug("IPC server request received - GET {}", request.get_resource());
+		auto max_age = get_max_age(request, default_max_age);
+		if (!max_age)
+			return invalid_max_age();
+
 		return nlohmann::json{
-			{"temperature", device->read_temperature().floating()}
+			{"temperature", get_temperature(managed_device, max_age.value()).floating()}
 		};
-	});
-	ipc_server.endpoint({"GET"}, "/firmware", [&](const auto&) -> ulocal::HttpResponse {
-		LOG->debug("IPC server request received - GET /firmware");
-		auto version = device->read_firmware_version();
+	}))));
+	ipc_server.deferred_endpoint({"GET"}, prefix + "/status", on_worker_pool(workers, with_device(find_device, with_device_attached([default_max_age](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		LOG->debug("IPC server request received - GET {}", request.get_resource());
+		auto max_age = get_max_age(request, default_max_age);
+		if (!max_age)
+			return invalid_max_age();
+
+		auto snapshot = get_snapshot(managed_device, max_age.value());
+		return nlohmann::json{
+			{"pump", {{"rpm", snapshot.pump_rpm}}},
+			{"fans", {{"rpm", snapshot.get_fans_rpm()}}},
+			{"temperature", snapshot.temperature.floating()}
+		};
+	}))));
+	ipc_server.endpoint({"GET"}, prefix + "/history", with_device(find_device, [](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		LOG->debug("IPC server request received - GET {}", request.get_resource());
+		auto sensor_arg = request.get_argument("sensor");
+		const auto* series = sensor_arg ? managed_device.get_history().get_series(sensor_arg->get_value()) : nullptr;
+		if (!series)
+		{
+			return {400, nlohmann::json{
+				{"error", fmt::format("Argument 'sensor' needs to be one of 'pump', 'fan0'...'fan{}' or 'temperature'.", managed_device.get_fan_count() - 1)}
+			}};
+		}
+
+		auto from = std::optional<std::int64_t>{0};
+		if (auto from_arg = request.get_argument("from"); from_arg)
+			from = convert<std::int64_t>(from_arg->get_value());
+
+		auto step = std::optional<std::int64_t>{1};
+		if (auto step_arg = request.get_argument("step"); step_arg)
+			step = convert<std::int64_t>(step_arg->get_value());
+
+		auto points = from && step ? series->query(from.value(), step.value()) : std::nullopt;
+		if (!points)
+		{
+			return {400, nlohmann::json{
+				{"error", "Argument 'from' needs to be number of seconds since epoch and 'step' needs to be multiple of 1, 60 or 3600 seconds."}
+			}};
+		}
+
+		auto result = nlohmann::json::array();
+		for (const auto& point : points.value())
+		{
+			result.push_back(nlohmann::json{
+				{"time", point.time},
+				{"min", point.min},
+				{"max", point.max},
+				{"avg", point.avg}
+			});
+		}
+
+		return nlohmann::json{
+			{"sensor", sensor_arg->get_value()},
+			{"step", step.value()},
+			{"points", result}
+		};
+	}));
+	ipc_server.deferred_endpoint({"GET"}, prefix + "/firmware", on_worker_pool(workers, with_device(find_device, with_device_attached([](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
+		LOG->debug("IPC server request received - GET {}", request.get_resource());
+		auto version = managed_device.submit([&](BaseDevice& device) { return device.read_firmware_version(); }).get();
 		return nlohmann::json{
 			{"version", {
 				{"major", std::get<0>(version)},
@@ -90,69 +310,449 @@ void CCoolDaemon::run(const std::string& interface)
 				{"patch", std::get<2>(version)}
 			}}
 		};
-	});
-	ipc_server.endpoint({"POST"}, "/pump", [&](const auto& request) -> ulocal::HttpResponse {
+	}))));
+	ipc_server.deferred_endpoint({"POST"}, prefix + "/pump", on_worker_pool(workers, with_device(find_device, with_device_attached([](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
 		auto mode = request.get_json()["mode"].template get<std::uint8_t>();
-		LOG->debug("IPC server request received - POST /pump mode={:d}", mode);
-		device->write_pump_mode(mode);
+		LOG->debug("IPC server request received - POST {} mode={:d}", request.get_resource(), mode);
+		managed_device.write_pump_mode(mode).get();
 		return nlohmann::json::object();
-	});
-	ipc_server.endpoint({"POST"}, "/fans", [&](const auto& request) -> ulocal::HttpResponse {
+	}))));
+	ipc_server.deferred_endpoint({"POST"}, prefix + "/fans", on_worker_pool(workers, with_device(find_device, with_device_attached([](const auto& request, ManagedDevice& managed_device) -> ulocal::HttpResponse {
 		auto request_json = request.get_json();
 		if (request_json.find("rpm") != request_json.end())
 		{
 			auto rpm = request_json["rpm"].template get<std::uint16_t>();
-			LOG->debug("IPC server request received - POST /fans rpm={:d}", rpm);
-			device->write_fans_rpm(rpm);
+			LOG->debug("IPC server request received - POST {} rpm={:d}", request.get_resource(), rpm);
+			managed_device.write_fans_rpm(rpm).get();
 		}
 		else if (request_json.find("pwm") != request_json.end())
 		{
 			auto pwm = request_json["pwm"].template get<std::uint8_t>();
-			LOG->debug("IPC server request received - POST /fans pwm={:d}", pwm);
-			device->write_fans_pwm(pwm);
+			LOG->debug("IPC server request received - POST {} pwm={:d}", request.get_resource(), pwm);
+			managed_device.write_fans_pwm(pwm).get();
 		}
 		else if (request_json.find("curve") != request_json.end())
 		{
-			auto temperatures = std::vector<std::uint8_t>{};
-			auto pwms = std::vector<std::uint8_t>{};
+			FansCurve curve;
 			for (const auto& point : request_json["curve"])
 			{
-				temperatures.push_back(point["temperature"].template get<std::uint8_t>());
-				pwms.push_back(point["pwm"].template get<std::uint8_t>());
+				if (!curve.add_point(point["temperature"].template get<std::uint8_t>(), point["pwm"].template get<std::uint8_t>()))
+				{
+					LOG->warn("IPC server request received - POST {} with too many curve points", request.get_resource());
+					return {400, nlohmann::json{
+						{"error", fmt::format("Fan curve can have at most {} points.", FansCurve::MaxPoints)}
+					}};
+				}
 			}
-			LOG->debug("IPC server request received - POST /fans temps=[{}] pwms=[{}]", fmt::join(temperatures.begin(), temperatures.end(), ", "), fmt::join(pwms.begin(), pwms.end(), ", "));
-			device->write_fans_curve(temperatures, pwms);
+			LOG->debug("IPC server request received - POST {} temps=[{}] pwms=[{}]", request.get_resource(), fmt::join(curve.get_temperatures(), ", "), fmt::join(curve.get_pwms(), ", "));
+			managed_device.write_fans_curve(curve).get();
 		}
 		else
 		{
-			LOG->warn("IPC server request received - POST /fans with unknown parameter");
+			LOG->warn("IPC server request received - POST {} with unknown parameter", request.get_resource());
 			return {400, nlohmann::json{
 				{"error", "Either 'rpm' or 'pwm' needs to be set."}
 			}};
 		}
 
 		return nlohmann::json::object();
+	}))));
+}
+
+/**
+ * Runs operation of the binary IPC in the worker pool and reports its errors the same
+ * way the HTTP endpoints do.
+ */
+template <typename Fn>
+void submit_binary_request(WorkerPool& workers, const BinaryIpcResponder& responder, Fn&& fn)
+{
+	workers.submit([responder, fn = std::forward<Fn>(fn)]() {
+		try
+		{
+			fn();
+		}
+		catch (const DeviceDetachedError&)
+		{
+			responder.send_error(IpcStatus::DeviceDetached);
+		}
+		catch (const std::exception& err)
+		{
+			LOG->error("Binary IPC request failed: {}", err.what());
+			responder.send_error(IpcStatus::Failed);
+		}
 	});
+}
+
+std::int32_t to_millidegrees(const FixedPoint<16>& temperature)
+{
+	return static_cast<std::int32_t>(std::lround(temperature.floating() * 1000.0));
+}
+
+/**
+ * Performs request received over the binary IPC. Operations mirror the HTTP endpoints of the device.
+ */
+void perform_binary_request(WorkerPool& workers, ManagedDevice* managed_device, std::chrono::milliseconds default_max_age, const IpcRequestHeader& header, std::string_view payload, const BinaryIpcResponder& responder)
+{
+	static_assert(IpcMaxCurvePoints == FansCurve::MaxPoints);
+
+	LOG->debug("Binary IPC request received - operation {} device={}", static_cast<std::uint16_t>(header.operation), header.device_id);
+	if (!managed_device)
+	{
+		responder.send_error(IpcStatus::DeviceNotFound);
+		return;
+	}
+
+	auto get_max_age = [&](const IpcReadRequest& request) {
+		return request.max_age == IpcDefaultMaxAge ? default_max_age : std::chrono::milliseconds{request.max_age};
+	};
+
+	switch (header.operation)
+	{
+		case IpcOperation::ReadStatus:
+			if (auto request = decode_ipc<IpcReadRequest>(payload); request)
+			{
+				submit_binary_request(workers, responder, [managed_device, responder, max_age = get_max_age(request.value())]() {
+					auto snapshot = get_snapshot(*managed_device, max_age);
+					IpcStatusResponse response = {};
+					response.pump_rpm = snapshot.pump_rpm;
+					response.fan_count = static_cast<std::uint16_t>(snapshot.fan_count);
+					std::copy_n(snapshot.fans_rpm.begin(), response.fan_count, response.fans_rpm.begin());
+					response.temperature = to_millidegrees(snapshot.temperature);
+					responder.send(response);
+				});
+				return;
+			}
+			break;
+		case IpcOperation::ReadPump:
+			if (auto request = decode_ipc<IpcReadRequest>(payload); request)
+			{
+				submit_binary_request(workers, responder, [managed_device, responder, max_age = get_max_age(request.value())]() {
+					responder.send(IpcPumpResponse{get_pump_rpm(*managed_device, max_age)});
+				});
+				return;
+			}
+			break;
+		case IpcOperation::ReadFans:
+			if (auto request = decode_ipc<IpcReadRequest>(payload); request)
+			{
+				submit_binary_request(workers, responder, [managed_device, responder, max_age = get_max_age(request.value())]() {
+					auto fans_rpm = get_fans_rpm(*managed_device, max_age);
+					IpcFansResponse response = {};
+					response.fan_count = static_cast<std::uint16_t>(std::min(fans_rpm.size(), IpcMaxFans));
+					std::copy_n(fans_rpm.begin(), response.fan_count, response.rpm.begin());
+					responder.send(response);
+				});
+				return;
+			}
+			break;
+		case IpcOperation::ReadTemperature:
+			if (auto request = decode_ipc<IpcReadRequest>(payload); request)
+			{
+				submit_binary_request(workers, responder, [managed_device, responder, max_age = get_max_age(request.value())]() {
+					responder.send(IpcTemperatureResponse{to_millidegrees(get_temperature(*managed_device, max_age))});
+				});
+				return;
+			}
+			break;
+		case IpcOperation::ReadFirmware:
+			if (decode_ipc<IpcEmptyPayload>(payload))
+			{
+				submit_binary_request(workers, responder, [managed_device, responder]() {
+					auto version = managed_device->submit([&](BaseDevice& device) { return device.read_firmware_version(); }).get();
+					responder.send(IpcFirmwareResponse{std::get<0>(version), std::get<1>(version), std::get<2>(version)});
+				});
+				return;
+			}
+			break;
+		case IpcOperation::WritePumpMode:
+			if (auto request = decode_ipc<IpcWritePumpModeRequest>(payload); request)
+			{
+				submit_binary_request(workers, responder, [managed_device, responder, mode = request->mode]() {
+					managed_device->write_pump_mode(mode).get();
+					responder.send();
+				});
+				return;
+			}
+			break;
+		case IpcOperation::WriteFansPwm:
+			if (auto request = decode_ipc<IpcWriteFansPwmRequest>(payload); request)
+			{
+				submit_binary_request(workers, responder, [managed_device, responder, pwm = request->pwm]() {
+					managed_device->write_fans_pwm(pwm).get();
+					responder.send();
+				});
+				return;
+			}
+			break;
+		case IpcOperation::WriteFansRpm:
+			if (auto request = decode_ipc<IpcWriteFansRpmRequest>(payload); request)
+			{
+				submit_binary_request(workers, responder, [managed_device, responder, rpm = request->rpm]() {
+					managed_device->write_fans_rpm(rpm).get();
+					responder.send();
+				});
+				return;
+			}
+			break;
+		case IpcOperation::WriteFansCurve:
+			if (auto request = decode_ipc<IpcWriteFansCurveRequest>(payload); request && request->size <= IpcMaxCurvePoints)
+			{
+				FansCurve curve;
+				for (std::size_t i = 0; i < request->size; ++i)
+					curve.add_point(request->temperatures[i], request->pwms[i]);
+
+				submit_binary_request(workers, responder, [managed_device, responder, curve]() {
+					managed_device->write_fans_curve(curve).get();
+					responder.send();
+				});
+				return;
+			}
+			break;
+		default:
+			responder.send_error(IpcStatus::UnknownOperation);
+			return;
+	}
 
-	auto ipc_thread = std::thread([&]() {
-		ipc_server.serve();
+	responder.send_error(IpcStatus::InvalidRequest);
+}
+
+} // namespace
+
+CCoolDaemon::CCoolDaemon(const std::string& socket_path, const std::optional<std::string>& binary_socket_path, bool daemonize, std::chrono::milliseconds sample_interval)
+	: _socket_path(socket_path), _binary_socket_path(binary_socket_path), _daemonize(daemonize), _sample_interval(sample_interval)
+{
+}
+
+void CCoolDaemon::run(const std::string& interface)
+{
+	using namespace std::literals;
+
+	std::shared_ptr<spdlog::logger> logger;
+	if (_daemonize)
+	{
+		daemonize();
+		logger = spdlog::systemd_logger_mt(LOGGER_NAME);
+	}
+	else
+		logger = spdlog::stdout_color_mt(LOGGER_NAME);
+
+	// Everything except the device I/O itself is done by this single event loop
+	EventLoop event_loop;
+	SignalWatcher termination_signals(event_loop, {SIGINT, SIGTERM}, [&](int) {
+		event_loop.stop();
 	});
 
-	auto last_time = std::chrono::steady_clock::now();
-	while (!quit_requested)
+	LOG->set_level(spdlog::level::debug);
+	LOG->error("Test error");
+
+	// Hotplug events are reported from other threads so they are queued and handled by the event loop
+	MpscQueue<HotplugEvent> hotplug_events;
+	std::function<void()> handle_hotplug_events;
+
+	DeviceDetector device_detector;
+	auto detected_devices = device_detector.detect_devices(interface);
+	device_detector.use_event_loop(event_loop);
+	auto hotplug = device_detector.watch_hotplug([&](HotplugEvent&& event) {
+		hotplug_events.push(std::move(event));
+		event_loop.post([&]() {
+			handle_hotplug_events();
+		});
+	});
+	if (detected_devices.empty() && !hotplug)
 	{
-		auto time_delta = std::chrono::steady_clock::now() - last_time;
-		LOG->debug("Next iteration ({:%M:%S}.{:#03d} passed)", time_delta, time_delta.count() % 1000);
+		LOG->info("No device found. Exiting...");
+		return;
+	}
+
+	// Without sampling, there is nothing to keep the cache fresh so read the sensors on every request
+	auto default_max_age = _sample_interval.count() > 0 ? std::chrono::milliseconds::max() : 0ms;
+
+	std::filesystem::remove(_socket_path);
+	ulocal::HttpServer ipc_server(_socket_path);
+
+	ipc_server.set_fd_notifiers(
+		[&](int fd) {
+			// epoll events have the same values as the poll ones. Server drains every
+			// descriptor once it is ready. Responses which do not fit into the socket
+			// buffer are finished only after the descriptor becomes writable again.
+			event_loop.add_fd(fd, EPOLLIN | EPOLLOUT | EPOLLET, [&, fd](std::uint32_t events) {
+				ipc_server.handle_fd(fd, static_cast<short>(events));
+			});
+		},
+		[&](int fd) {
+			event_loop.remove_fd(fd);
+		}
+	);
 
-		last_time = std::chrono::steady_clock::now();
-		std::this_thread::sleep_for(1s);
+	// Every device has its own worker so they are all accessed in parallel. Devices are never
+	// removed from here so their IDs stay the same even if they are detached and attached back.
+	std::vector<std::unique_ptr<ManagedDevice>> devices;
+	// Devices are only added by the event loop but requests look them up from the worker pool too
+	std::mutex devices_mutex;
+
+	auto find_device_by_id = [&](std::uint32_t id) -> ManagedDevice* {
+		std::lock_guard lock(devices_mutex);
+		return id < devices.size() ? devices[id].get() : nullptr;
+	};
+
+	// Routes without device ID operate on the first device
+	DeviceFinder find_device = [&](const ulocal::HttpRequest& request) -> ManagedDevice* {
+		auto id_param = request.get_route_param("id");
+		auto id = id_param ? convert<std::uint32_t>(id_param.value()) : std::optional<std::uint32_t>{0};
+		return id ? find_device_by_id(id.value()) : nullptr;
+	};
+
+	// Created only once the worker pool exists but needs to outlive it
+	std::optional<BinaryIpcServer> binary_ipc_server;
+
+	// Requests waiting for devices are served from here so they never stall the event loop. It is
+	// declared after everything the requests use so it finishes them before those are destroyed.
+	WorkerPool workers(IpcWorkerCount);
+
+	if (_binary_socket_path)
+	{
+		std::filesystem::remove(_binary_socket_path.value());
+		binary_ipc_server.emplace(event_loop, _binary_socket_path.value(), [&](const IpcRequestHeader& header, std::string_view payload, const BinaryIpcResponder& responder) {
+			perform_binary_request(workers, find_device_by_id(header.device_id), default_max_age, header, payload, responder);
+		});
 	}
 
-	ipc_server.terminate();
-	ipc_server.wait_until_done();
-	ipc_thread.join();
+	// Single timer is always armed for the closest sample of all devices
+	Timer sample_timer(event_loop, [&]() {
+		auto next_sample_time = Clock::time_point::max();
+		for (auto& managed_device : devices)
+			next_sample_time = std::min(next_sample_time, managed_device->poll_sampler());
+		sample_timer.arm(next_sample_time);
+	});
+
+	auto attach_device = [&](std::unique_ptr<BaseDevice>&& device) {
+		auto itr = std::find_if(devices.begin(), devices.end(), [&](const auto& managed_device) {
+			return managed_device->get_location() == device->get_location() && managed_device->get_name() == device->get_name();
+		});
+		if (itr != devices.end())
+		{
+			if ((*itr)->is_attached())
+				return;
+
+			LOG->info("Device '{}' with ID {} attached again", device->get_name(), (*itr)->get_id());
+			(*itr)->attach(std::move(device));
+			return;
+		}
+
+		auto id = static_cast<std::uint32_t>(devices.size());
+		LOG->info("Using device '{}' with ID {}", device->get_name(), id);
+
+		std::lock_guard lock(devices_mutex);
+		devices.emplace_back(std::make_unique<ManagedDevice>(id, std::move(device), _sample_interval));
+	};
+
+	auto is_attached = [&](const std::string& location) {
+		return std::any_of(devices.begin(), devices.end(), [&](const auto& managed_device) {
+			return managed_device->get_location() == location && managed_device->is_attached();
+		});
+	};
+
+	auto detach_device = [&](const std::string& location) {
+		for (auto& managed_device : devices)
+		{
+			if (managed_device->get_location() == location && managed_device->is_attached())
+			{
+				LOG->info("Device '{}' with ID {} detached", managed_device->get_name(), managed_device->get_id());
+				managed_device->detach();
+			}
+		}
+	};
+
+	for (auto&& device : detected_devices)
+		attach_device(std::move(device));
+
+	register_device_endpoints(ipc_server, workers, "/devices/{id}", find_device, default_max_age);
+	register_device_endpoints(ipc_server, workers, "", find_device, default_max_age);
+
+	ipc_server.deferred_endpoint({"GET"}, "/devices", [&](const ulocal::HttpRequest& request, const ulocal::HttpResponder& responder) {
+		// Devices are added by the event loop so the worker needs its own copy of the list
+		std::vector<ManagedDevice*> device_list(devices.size());
+		std::transform(devices.begin(), devices.end(), device_list.begin(), [](const auto& managed_device) { return managed_device.get(); });
+
+		on_worker_pool(workers, [&, device_list = std::move(device_list)](const auto& request) -> ulocal::HttpResponse {
+			LOG->debug("IPC server request received - GET /devices");
+			auto max_age = get_max_age(request, default_max_age);
+			if (!max_age)
+				return invalid_max_age();
+
+			// Refresh all outdated devices at once so the whole sweep takes only as long as the slowest device
+			std::vector<std::shared_future<void>> refreshes;
+			for (auto* managed_device : device_list)
+			{
+				auto& telemetry = managed_device->get_telemetry();
+				if (!telemetry.pump_rpm.get(max_age.value()) || !telemetry.fans_rpm.get(max_age.value()) || !telemetry.temperature.get(max_age.value()))
+				{
+					try
+					{
+						refreshes.push_back(managed_device->read_sensors());
+					}
+					catch (const DeviceDetachedError&)
+					{
+					}
+				}
+			}
+
+			for (auto& refresh : refreshes)
+				refresh.wait();
+
+			auto result = nlohmann::json::array();
+			for (auto* managed_device : device_list)
+			{
+				auto& telemetry = managed_device->get_telemetry();
+				auto pump_rpm = telemetry.pump_rpm.get();
+				auto fans_rpm = telemetry.fans_rpm.get();
+				auto temperature = telemetry.temperature.get();
+				result.push_back(nlohmann::json{
+					{"id", managed_device->get_id()},
+					{"name", managed_device->get_name()},
+					{"fan_count", managed_device->get_fan_count()},
+					{"attached", managed_device->is_attached()},
+					{"pump", pump_rpm ? nlohmann::json{{"rpm", pump_rpm.value()}} : nlohmann::json{}},
+					{"fans", fans_rpm ? nlohmann::json{{"rpm", fans_rpm.value()}} : nlohmann::json{}},
+					{"temperature", temperature ? nlohmann::json(temperature->floating()) : nlohmann::json{}}
+				});
+			}
+
+			return nlohmann::json{
+				{"devices", result}
+			};
+		})(request, responder);
+	});
+
+	handle_hotplug_events = [&]() {
+		while (auto event = hotplug_events.pop())
+		{
+			if (event->type == HotplugEvent::Type::Attached)
+			{
+				// Devices found during the detection can be reported again
+				if (is_attached(event->location))
+					continue;
+
+				if (auto device = device_detector.create_device(std::move(event->device_interface)); device)
+				{
+					attach_device(std::move(device));
+					sample_timer.arm(Clock::now());
+				}
+			}
+			else
+				detach_device(event->location);
+		}
+	};
+
+	ipc_server.listen();
+	if (binary_ipc_server)
+		binary_ipc_server->listen();
+	sample_timer.arm(Clock::now());
+	event_loop.run();
 
 	std::filesystem::remove(_socket_path);
+	if (_binary_socket_path)
+		std::filesystem::remove(_binary_socket_path.value());
 }
 
 } // namespace ccool
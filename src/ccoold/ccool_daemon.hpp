@@ -1,5 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <optional>
+#include <string>
+
 #include "device_detector.hpp"
 
 namespace ccool {
@@ -7,13 +11,15 @@ namespace ccool {
 class CCoolDaemon
 {
 public:
-	CCoolDaemon(const std::string& socket_path, bool daemonize);
+	CCoolDaemon(const std::string& socket_path, const std::optional<std::string>& binary_socket_path, bool daemonize, std::chrono::milliseconds sample_interval);
 
 	void run(const std::string& interface);
 
 private:
 	std::string _socket_path;
+	std::optional<std::string> _binary_socket_path;
 	bool _daemonize;
+	std::chrono::milliseconds _sample_interval;
 };
 
 } // namespace ccool
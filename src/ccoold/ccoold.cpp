@@ -8,9 +8,11 @@ int main(int argc, char* argv[])
 {
 	cxxopts::Options options("ccoold", "CCool daemon");
 	options.add_options()
+		("binary-socket", "Also serve binary IPC on specified socket", cxxopts::value<std::string>())
 		("h,help", "Show usage")
 		("i,interface", "Interface to use", cxxopts::value<std::string>()->default_value("usb"))
 		("n,no-daemon", "Do not run daemonized")
+		("sample-interval", "Interval between sensor samples in milliseconds (0 disables sampling)", cxxopts::value<std::uint32_t>()->default_value("1000"))
 		("s,socket", "Use specified socket", cxxopts::value<std::string>()->default_value("/var/run/ccool/ccoold.sock"))
 		("v,verbose", "Verbose logging messages")
 		("version", "Show version information")
@@ -24,7 +26,12 @@ int main(int argc, char* argv[])
 		return 0;
 	}
 
-	ccool::CCoolDaemon ccool_daemon(result["socket"].as<std::string>(), result["no-daemon"].count() == 0u);
+	ccool::CCoolDaemon ccool_daemon(
+		result["socket"].as<std::string>(),
+		result.count("binary-socket") ? std::make_optional(result["binary-socket"].as<std::string>()) : std::nullopt,
+		result["no-daemon"].count() == 0u,
+		std::chrono::milliseconds{result["sample-interval"].as<std::uint32_t>()}
+	);
 	ccool_daemon.run(result["interface"].as<std::string>());
 	return 0;
 }
@@ -1,47 +1,74 @@
 #pragma once
 
+#include <span>
 #include <string>
 
 #include <interfaces/device_interface.hpp>
+#include <protocol.hpp>
+#include <session.hpp>
 
 namespace ccool {
 
 class BaseDevice
 {
 public:
-	BaseDevice(const std::string& name, std::uint32_t fan_count, std::uint8_t data_endpoint) : _name(name), _fan_count(fan_count), _data_endpoint(data_endpoint) {}
+	BaseDevice(const std::string& name, const std::string& location, std::uint32_t fan_count, std::uint8_t data_endpoint, const std::shared_ptr<BufferPool>& buffer_pool)
+		: _name(name), _location(location), _fan_count(fan_count), _data_endpoint(data_endpoint), _buffer_pool(buffer_pool) {}
 	virtual ~BaseDevice() = default;
 
 	const std::string& get_name() const { return _name; }
+	const std::string& get_location() const { return _location; }
 	std::uint32_t get_fan_count() const { return _fan_count; }
+	const std::shared_ptr<BufferPool>& get_buffer_pool() const { return _buffer_pool; }
+
+	// Groups multiple operations so they share single protocol session. Use `Session<BaseDevice>`.
+	virtual void begin_session() = 0;
+	virtual void end_session() = 0;
 
 	virtual std::uint16_t read_pump_rpm() = 0;
 	virtual std::vector<std::uint16_t> read_fans_rpm() = 0;
 	virtual FixedPoint<16> read_temperature() = 0;
+	virtual SensorSnapshot read_snapshot() = 0;
 	virtual std::tuple<std::uint8_t, std::uint8_t, std::uint8_t> read_firmware_version() = 0;
 	virtual void write_pump_mode(std::uint8_t mode) = 0;
 	virtual void write_fans_pwm(std::uint8_t pwm) = 0;
 	virtual void write_fans_rpm(std::uint16_t rpm) = 0;
-	virtual void write_fans_curve(const std::vector<std::uint8_t>& temperatures, const std::vector<std::uint8_t>& pwms) = 0;
+	virtual void write_fans_curve(std::span<const std::uint8_t> temperatures, std::span<const std::uint8_t> pwms) = 0;
 
 protected:
 	std::string _name;
+	std::string _location;
 	std::uint32_t _fan_count;
 	std::uint8_t _data_endpoint;
+	std::shared_ptr<BufferPool> _buffer_pool;
 };
 
-template <typename ProtocolT>
+/**
+ * Binds concrete protocol to `BaseDevice`. Protocol is held by value and its messages are
+ * not virtual so the only indirect call is the one into `BaseDevice` per high-level operation.
+ */
+template <DeviceProtocol ProtocolT>
 class Device : public BaseDevice
 {
 public:
 	Device(std::unique_ptr<DeviceInterface>&& device_interface, const std::string& name, std::uint32_t fan_count, std::uint8_t data_endpoint)
-		: BaseDevice(name, fan_count, data_endpoint), _device_interface(std::move(device_interface)), _protocol(_device_interface.get())
+		: BaseDevice(name, device_interface->get_location(), fan_count, data_endpoint, device_interface->get_buffer_pool()), _device_interface(std::move(device_interface)), _protocol(_device_interface.get())
 	{
 		_device_interface->bind();
 	}
 
 	virtual ~Device() = default;
 
+	virtual void begin_session() override
+	{
+		_protocol.begin_session();
+	}
+
+	virtual void end_session() override
+	{
+		_protocol.end_session();
+	}
+
 	virtual std::uint16_t read_pump_rpm() override
 	{
 		return _protocol.read_pump_rpm(_data_endpoint);
@@ -50,8 +77,10 @@ public:
 	virtual std::vector<std::uint16_t> read_fans_rpm() override
 	{
 		std::vector<std::uint16_t> result(_fan_count, 0);
+		Session session(_protocol);
 		for (std::uint8_t i = 0; i < _fan_count; ++i)
 			std::tie(std::ignore, result[i]) = _protocol.read_fan_rpm(_data_endpoint, i);
+		session.close();
 		return result;
 	}
 
@@ -60,6 +89,33 @@ public:
 		return _protocol.read_temperature(_data_endpoint);
 	}
 
+	/**
+	 * Uses native multi-sensor message if the protocol spec declares one. Otherwise reads sensors
+	 * one by one within single session so they share the control requests.
+	 */
+	virtual SensorSnapshot read_snapshot() override
+	{
+		if constexpr (requires { { _protocol.read_snapshot(_data_endpoint) } -> std::same_as<SensorSnapshot>; })
+		{
+			// Message may report different number of fans than the device has, fans it does not report are zero
+			auto result = _protocol.read_snapshot(_data_endpoint);
+			result.fan_count = _fan_count;
+			return result;
+		}
+		else
+		{
+			SensorSnapshot result;
+			result.fan_count = _fan_count;
+			Session session(_protocol);
+			result.pump_rpm = _protocol.read_pump_rpm(_data_endpoint);
+			for (std::uint8_t i = 0; i < _fan_count; ++i)
+				std::tie(std::ignore, result.fans_rpm[i]) = _protocol.read_fan_rpm(_data_endpoint, i);
+			result.temperature = _protocol.read_temperature(_data_endpoint);
+			session.close();
+			return result;
+		}
+	}
+
 	virtual std::tuple<std::uint8_t, std::uint8_t, std::uint8_t> read_firmware_version() override
 	{
 		return _protocol.read_firmware_version(_data_endpoint);
@@ -72,20 +128,33 @@ public:
 
 	virtual void write_fans_pwm(std::uint8_t pwm) override
 	{
+		Session session(_protocol);
 		for (std::uint8_t i = 0; i < _fan_count; ++i)
 			_protocol.write_fan_pwm(_data_endpoint, i, pwm);
+		session.close();
 	}
 
 	virtual void write_fans_rpm(std::uint16_t rpm) override
 	{
+		Session session(_protocol);
 		for (std::uint8_t i = 0; i < _fan_count; ++i)
 			_protocol.write_fan_rpm(_data_endpoint, i, rpm);
+		session.close();
 	}
 
-	virtual void write_fans_curve(const std::vector<std::uint8_t>& temperatures, const std::vector<std::uint8_t>& pwms)
+	virtual void write_fans_curve(std::span<const std::uint8_t> temperatures, std::span<const std::uint8_t> pwms) override
 	{
+		// Curve is the same for all fans so it is encoded only once and just the fan index is changed
+		using Layout = typename ProtocolT::WriteFanCurveLayout;
+		auto request = Layout::encode(0, temperatures, pwms);
+
+		Session session(_protocol);
 		for (std::uint8_t i = 0; i < _fan_count; ++i)
-			_protocol.write_fan_curve(_data_endpoint, i, temperatures, pwms);
+		{
+			Layout::set_fan_index(request, i);
+			_protocol.write_fan_curve(_data_endpoint, request);
+		}
+		session.close();
 	}
 
 	void write_custom_led_color_enabled(std::uint8_t endpoint, std::uint8_t enabled);
@@ -6,31 +6,58 @@
 
 namespace ccool {
 
-std::unique_ptr<BaseDevice> DeviceDetector::detect_device(const std::string& interface_name)
+std::vector<std::unique_ptr<BaseDevice>> DeviceDetector::detect_devices(const std::string& interface_name)
 {
 	spdlog::info("Detecting devices using interface '{}'...", interface_name);
 
 	_interface = Interface::create(interface_name);
 	if (!_interface)
-		return nullptr;
+		return {};
 
-	std::unique_ptr<BaseDevice> result;
+	std::vector<std::unique_ptr<BaseDevice>> result;
 	auto device_ifs = _interface->get_device_interfaces();
 	for (auto&& device_if : device_ifs)
 	{
-		auto vendor_id = device_if->get_vendor_id();
-		auto product_id = device_if->get_product_id();
-
-		LOG->debug("  - {:#06x}:{:#06x}", vendor_id, product_id);
-		result = check_known_devices(vendor_id, product_id, std::move(device_if));
-		if (result)
-		{
-			LOG->debug("     - known device '{}'", result->get_name());
-			break;
-		}
+		if (auto device = create_device(std::move(device_if)); device)
+			result.push_back(std::move(device));
 	}
 
 	return result;
 }
 
+std::unique_ptr<BaseDevice> DeviceDetector::create_device(std::unique_ptr<DeviceInterface>&& device_interface)
+{
+	try
+	{
+		auto vendor_id = device_interface->get_vendor_id();
+		auto product_id = device_interface->get_product_id();
+
+		LOG->debug("  - {:#06x}:{:#06x} at {}", vendor_id, product_id, device_interface->get_location());
+		auto device = check_known_devices(vendor_id, product_id, std::move(device_interface));
+		if (device)
+			LOG->debug("     - known device '{}'", device->get_name());
+
+		return device;
+	}
+	catch (const std::exception& error)
+	{
+		LOG->warn("Unable to use device: {}", error.what());
+		return nullptr;
+	}
+}
+
+bool DeviceDetector::watch_hotplug(HotplugCallback callback)
+{
+	if (!_interface)
+		return false;
+
+	return _interface->watch_hotplug(std::move(callback));
+}
+
+void DeviceDetector::use_event_loop(EventLoop& loop)
+{
+	if (_interface)
+		_interface->use_event_loop(loop);
+}
+
 } // namespace ccool
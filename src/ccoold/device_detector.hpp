@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "device.hpp"
 #include "interfaces/device_interface.hpp"
@@ -21,7 +22,23 @@ struct DeviceId
 class DeviceDetector
 {
 public:
-	std::unique_ptr<BaseDevice> detect_device(const std::string& interface_name);
+	std::vector<std::unique_ptr<BaseDevice>> detect_devices(const std::string& interface_name);
+
+	/**
+	 * Creates device if it is known. Returns nullptr for unknown devices or those which failed to bind.
+	 */
+	std::unique_ptr<BaseDevice> create_device(std::unique_ptr<DeviceInterface>&& device_interface);
+
+	/**
+	 * Reports devices attached and detached at runtime on the interface used by the last detection.
+	 * Returns false if the interface does not support hotplug.
+	 */
+	bool watch_hotplug(HotplugCallback callback);
+
+	/**
+	 * Processes events of the interface used by the last detection in the given event loop.
+	 */
+	void use_event_loop(EventLoop& loop);
 
 private:
 	std::unique_ptr<Interface> _interface;
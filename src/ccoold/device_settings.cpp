@@ -0,0 +1,29 @@
+#include "device_settings.hpp"
+
+namespace ccool {
+
+namespace {
+
+template <typename... Ts>
+struct Overloaded : Ts... { using Ts::operator()...; };
+
+} // namespace
+
+void DeviceSettings::apply(BaseDevice& device) const
+{
+	Session session(device);
+
+	if (pump_mode)
+		device.write_pump_mode(pump_mode.value());
+
+	std::visit(Overloaded{
+		[](std::monostate) {},
+		[&](const FansPwm& setting) { device.write_fans_pwm(setting.pwm); },
+		[&](const FansRpm& setting) { device.write_fans_rpm(setting.rpm); },
+		[&](const FansCurve& setting) { device.write_fans_curve(setting.get_temperatures(), setting.get_pwms()); }
+	}, fans);
+
+	session.close();
+}
+
+} // namespace ccool
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <variant>
+
+#include "device.hpp"
+
+namespace ccool {
+
+struct FansPwm
+{
+	std::uint8_t pwm;
+
+	bool operator==(const FansPwm&) const = default;
+};
+
+struct FansRpm
+{
+	std::uint16_t rpm;
+
+	bool operator==(const FansRpm&) const = default;
+};
+
+/**
+ * Points of the fan curve are stored inline so the curve can be passed all the way
+ * from IPC to the protocol without any allocations.
+ */
+struct FansCurve
+{
+	static constexpr std::size_t MaxPoints = 16;
+
+	std::array<std::uint8_t, MaxPoints> temperatures = {};
+	std::array<std::uint8_t, MaxPoints> pwms = {};
+	std::size_t size = 0;
+
+	bool operator==(const FansCurve&) const = default;
+
+	std::span<const std::uint8_t> get_temperatures() const { return {temperatures.data(), size}; }
+	std::span<const std::uint8_t> get_pwms() const { return {pwms.data(), size}; }
+
+	bool add_point(std::uint8_t temperature, std::uint8_t pwm)
+	{
+		if (size == MaxPoints)
+			return false;
+
+		temperatures[size] = temperature;
+		pwms[size] = pwm;
+		++size;
+		return true;
+	}
+};
+
+using FansSetting = std::variant<std::monostate, FansPwm, FansRpm, FansCurve>;
+
+/**
+ * Settings last written to the device. Device falls back to its firmware defaults
+ * whenever it is reset so these are written again once it is attached back.
+ * Only the last fan setting is kept since each of them replaces the previous one.
+ */
+struct DeviceSettings
+{
+	std::optional<std::uint8_t> pump_mode;
+	FansSetting fans;
+
+	bool operator==(const DeviceSettings&) const = default;
+
+	bool empty() const { return !pump_mode && std::holds_alternative<std::monostate>(fans); }
+	void apply(BaseDevice& device) const;
+};
+
+} // namespace ccool
@@ -0,0 +1,46 @@
+#include "device_worker.hpp"
+
+namespace ccool {
+
+DeviceWorker::DeviceWorker(std::unique_ptr<BaseDevice>&& device) : _device(std::move(device)), _commands(), _pending(0), _thread()
+{
+	_thread = std::thread([this]() {
+		run();
+	});
+}
+
+DeviceWorker::~DeviceWorker()
+{
+	// Empty command tells the worker to stop
+	push(Command{});
+	_thread.join();
+}
+
+void DeviceWorker::push(Command&& command)
+{
+	_commands.push(std::move(command));
+	_pending.release();
+}
+
+void DeviceWorker::run()
+{
+	while (true)
+	{
+		_pending.acquire();
+
+		auto command = _commands.pop();
+		while (!command)
+		{
+			// Producer is in the middle of pushing the command
+			std::this_thread::yield();
+			command = _commands.pop();
+		}
+
+		if (!command.value())
+			break;
+
+		command.value()(*_device);
+	}
+}
+
+} // namespace ccool
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <semaphore>
+#include <thread>
+#include <type_traits>
+
+#include "device.hpp"
+#include "mpsc_queue.hpp"
+
+namespace ccool {
+
+/**
+ * Thread which exclusively owns the device and performs all operations with it.
+ * Operations are submitted as commands through lock-free queue and are executed
+ * one by one in the order they were submitted so USB transfers of different
+ * operations are never interleaved.
+ */
+class DeviceWorker
+{
+public:
+	using Command = std::function<void(BaseDevice&)>;
+
+	DeviceWorker(std::unique_ptr<BaseDevice>&& device);
+	DeviceWorker(const DeviceWorker&) = delete;
+	DeviceWorker(DeviceWorker&&) noexcept = delete;
+	~DeviceWorker();
+
+	DeviceWorker& operator=(const DeviceWorker&) = delete;
+	DeviceWorker& operator=(DeviceWorker&&) noexcept = delete;
+
+	/**
+	 * Only immutable information about device (name, fan count, ...) can be read
+	 * directly. Everything else needs to be done through `submit()`.
+	 */
+	const BaseDevice& get_device() const { return *_device; }
+
+	template <typename Fn>
+	std::future<std::invoke_result_t<Fn, BaseDevice&>> submit(Fn&& fn)
+	{
+		using Result = std::invoke_result_t<Fn, BaseDevice&>;
+
+		auto task = std::make_shared<std::packaged_task<Result(BaseDevice&)>>(std::forward<Fn>(fn));
+		auto result = task->get_future();
+		push([task](BaseDevice& device) {
+			(*task)(device);
+		});
+		return result;
+	}
+
+private:
+	void push(Command&& command);
+	void run();
+
+	std::unique_ptr<BaseDevice> _device;
+	MpscQueue<Command> _commands;
+	std::counting_semaphore<> _pending;
+	std::thread _thread;
+};
+
+} // namespace ccool
@@ -0,0 +1,202 @@
+#include <array>
+#include <cerrno>
+#include <stdexcept>
+
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "event_loop.hpp"
+
+namespace ccool {
+
+EventLoop::EventLoop() : _epoll_fd(-1), _wakeup_fd(-1), _running(false), _mutex(), _fd_callbacks(), _tasks()
+{
+	_epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll_fd < 0)
+		throw std::runtime_error("Unable to create epoll instance");
+
+	_wakeup_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (_wakeup_fd < 0)
+	{
+		::close(_epoll_fd);
+		throw std::runtime_error("Unable to create eventfd");
+	}
+
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = _wakeup_fd;
+	::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _wakeup_fd, &event);
+}
+
+EventLoop::~EventLoop()
+{
+	::close(_wakeup_fd);
+	::close(_epoll_fd);
+}
+
+void EventLoop::add_fd(int fd, std::uint32_t events, FdCallback callback)
+{
+	std::lock_guard lock(_mutex);
+
+	epoll_event event = {};
+	event.events = events;
+	event.data.fd = fd;
+	if (::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0)
+	{
+		if (errno != EEXIST || ::epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, fd, &event) < 0)
+			throw std::runtime_error("Unable to add file descriptor to the event loop");
+	}
+
+	_fd_callbacks[fd] = std::make_shared<FdCallback>(std::move(callback));
+}
+
+void EventLoop::remove_fd(int fd)
+{
+	std::lock_guard lock(_mutex);
+
+	// Closed file descriptors are removed by the kernel itself so errors are fine here
+	::epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	_fd_callbacks.erase(fd);
+}
+
+void EventLoop::post(Task task)
+{
+	_tasks.push(std::move(task));
+	wake_up();
+}
+
+void EventLoop::run()
+{
+	std::array<epoll_event, 16> events;
+
+	_running = true;
+	while (_running)
+	{
+		auto count = ::epoll_wait(_epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			throw std::runtime_error("Failed while waiting for events");
+		}
+
+		for (int i = 0; i < count && _running; ++i)
+		{
+			auto fd = events[i].data.fd;
+			if (fd == _wakeup_fd)
+			{
+				run_tasks();
+				continue;
+			}
+
+			// Callback can remove its own file descriptor while it runs
+			std::shared_ptr<FdCallback> callback;
+			{
+				std::lock_guard lock(_mutex);
+				if (auto itr = _fd_callbacks.find(fd); itr != _fd_callbacks.end())
+					callback = itr->second;
+			}
+
+			if (callback)
+				(*callback)(events[i].events);
+		}
+	}
+}
+
+void EventLoop::stop()
+{
+	_running = false;
+	wake_up();
+}
+
+void EventLoop::wake_up()
+{
+	std::uint64_t value = 1;
+	[[maybe_unused]] auto result = ::write(_wakeup_fd, &value, sizeof(value));
+}
+
+void EventLoop::run_tasks()
+{
+	std::uint64_t value;
+	[[maybe_unused]] auto result = ::read(_wakeup_fd, &value, sizeof(value));
+
+	// Task which is still being pushed is picked up once its producer wakes us up
+	while (auto task = _tasks.pop())
+		task.value()();
+}
+
+Timer::Timer(EventLoop& loop, std::function<void()> callback) : _loop(loop), _fd(-1), _callback(std::move(callback))
+{
+	_fd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (_fd < 0)
+		throw std::runtime_error("Unable to create timerfd");
+
+	_loop.add_fd(_fd, EPOLLIN, [this](std::uint32_t) {
+		std::uint64_t expirations;
+		if (::read(_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+			_callback();
+	});
+}
+
+Timer::~Timer()
+{
+	_loop.remove_fd(_fd);
+	::close(_fd);
+}
+
+void Timer::arm(Clock::time_point time_point)
+{
+	if (time_point == Clock::time_point::max())
+		return disarm();
+
+	// Steady clock is CLOCK_MONOTONIC so its time points can be used directly
+	auto since_epoch = std::chrono::duration_cast<std::chrono::nanoseconds>(time_point.time_since_epoch());
+	if (since_epoch.count() <= 0)
+		since_epoch = std::chrono::nanoseconds{1};
+
+	itimerspec spec = {};
+	spec.it_value.tv_sec = static_cast<time_t>(since_epoch.count() / 1'000'000'000);
+	spec.it_value.tv_nsec = static_cast<long>(since_epoch.count() % 1'000'000'000);
+	::timerfd_settime(_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void Timer::disarm()
+{
+	itimerspec spec = {};
+	::timerfd_settime(_fd, 0, &spec, nullptr);
+}
+
+SignalWatcher::SignalWatcher(EventLoop& loop, std::initializer_list<int> signums, std::function<void(int)> callback)
+	: _loop(loop), _fd(-1), _callback(std::move(callback))
+{
+	sigset_t signal_set;
+	sigemptyset(&signal_set);
+	for (auto signum : signums)
+		sigaddset(&signal_set, signum);
+
+	// Signals need to be blocked otherwise they are still delivered the usual way
+	::pthread_sigmask(SIG_BLOCK, &signal_set, nullptr);
+
+	_fd = ::signalfd(-1, &signal_set, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (_fd < 0)
+		throw std::runtime_error("Unable to create signalfd");
+
+	_loop.add_fd(_fd, EPOLLIN, [this](std::uint32_t) {
+		signalfd_siginfo info;
+		while (::read(_fd, &info, sizeof(info)) == sizeof(info))
+			_callback(static_cast<int>(info.ssi_signo));
+	});
+}
+
+SignalWatcher::~SignalWatcher()
+{
+	_loop.remove_fd(_fd);
+	::close(_fd);
+}
+
+} // namespace ccool
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "mpsc_queue.hpp"
+#include "telemetry.hpp"
+
+namespace ccool {
+
+/**
+ * Event loop built on top of epoll. Everything the daemon waits for (timers, signals,
+ * IPC connections, USB transfers) is a file descriptor registered here, so the thread
+ * running the loop only wakes up when there is something to do.
+ *
+ * File descriptors can be added and removed and tasks can be posted from any thread.
+ */
+class EventLoop
+{
+public:
+	// Receives epoll events which are the same as the ones of poll()
+	using FdCallback = std::function<void(std::uint32_t events)>;
+	using Task = std::function<void()>;
+
+	EventLoop();
+	EventLoop(const EventLoop&) = delete;
+	EventLoop(EventLoop&&) noexcept = delete;
+	~EventLoop();
+
+	EventLoop& operator=(const EventLoop&) = delete;
+	EventLoop& operator=(EventLoop&&) noexcept = delete;
+
+	void add_fd(int fd, std::uint32_t events, FdCallback callback);
+	void remove_fd(int fd);
+
+	/**
+	 * Runs the task on the thread running the loop.
+	 */
+	void post(Task task);
+
+	/**
+	 * Runs the loop until `stop()` is called.
+	 */
+	void run();
+	void stop();
+
+private:
+	void wake_up();
+	void run_tasks();
+
+	int _epoll_fd;
+	int _wakeup_fd;
+	std::atomic<bool> _running;
+	std::mutex _mutex;
+	std::unordered_map<int, std::shared_ptr<FdCallback>> _fd_callbacks;
+	MpscQueue<Task> _tasks;
+};
+
+/**
+ * One-shot timer. Callback is run by the event loop once the time point it was armed for passes.
+ */
+class Timer
+{
+public:
+	Timer(EventLoop& loop, std::function<void()> callback);
+	Timer(const Timer&) = delete;
+	Timer(Timer&&) noexcept = delete;
+	~Timer();
+
+	Timer& operator=(const Timer&) = delete;
+	Timer& operator=(Timer&&) noexcept = delete;
+
+	/**
+	 * Arms the timer replacing the previous time point. Time point `Clock::time_point::max()` disarms it.
+	 */
+	void arm(Clock::time_point time_point);
+	void disarm();
+
+private:
+	EventLoop& _loop;
+	int _fd;
+	std::function<void()> _callback;
+};
+
+/**
+ * Delivers signals through the event loop instead of interrupting whichever thread is running.
+ * Signals get blocked for the calling thread and all threads it starts afterwards so this needs
+ * to be created before any other thread.
+ */
+class SignalWatcher
+{
+public:
+	SignalWatcher(EventLoop& loop, std::initializer_list<int> signums, std::function<void(int)> callback);
+	SignalWatcher(const SignalWatcher&) = delete;
+	SignalWatcher(SignalWatcher&&) noexcept = delete;
+	~SignalWatcher();
+
+	SignalWatcher& operator=(const SignalWatcher&) = delete;
+	SignalWatcher& operator=(SignalWatcher&&) noexcept = delete;
+
+private:
+	EventLoop& _loop;
+	int _fd;
+	std::function<void(int)> _callback;
+};
+
+} // namespace ccool
@@ -0,0 +1,223 @@
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CCOOL_HEX_X86
+#endif
+
+#include "hex.hpp"
+
+namespace ccool {
+
+namespace {
+
+inline char nibble_to_hex_char(std::uint8_t nibble)
+{
+	return static_cast<char>(nibble <= 9 ? nibble + '0' : nibble - 10 + 'a');
+}
+
+inline std::uint8_t hex_char_to_nibble(char hex_char)
+{
+	if ('0' <= hex_char && hex_char <= '9')
+		return static_cast<std::uint8_t>(hex_char - '0');
+
+	hex_char = static_cast<char>(hex_char | 0x20);
+	if ('a' <= hex_char && hex_char <= 'f')
+		return static_cast<std::uint8_t>(hex_char - 'a' + 10);
+
+	throw std::runtime_error("Invalid hex char when converting to bytes");
+}
+
+#if defined(CCOOL_HEX_X86) && defined(__SSE2__)
+
+// Nibbles in [0, 15] to their hex characters
+inline __m128i nibbles_to_hex_sse2(__m128i nibbles)
+{
+	auto letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+void hex_encode_sse2(const std::uint8_t* data, std::size_t size, char* hex)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		auto high = nibbles_to_hex_sse2(_mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F)));
+		auto low = nibbles_to_hex_sse2(_mm_and_si128(bytes, _mm_set1_epi8(0x0F)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 2*i), _mm_unpacklo_epi8(high, low));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 2*i + 16), _mm_unpackhi_epi8(high, low));
+	}
+
+	hex_encode_scalar(data + i, size - i, hex + 2*i);
+}
+
+// Hex characters to nibbles. Lanes with invalid characters are reported in `valid` as zeroes.
+inline __m128i hex_to_nibbles_sse2(__m128i chars, __m128i& valid)
+{
+	auto lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+	auto is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+	auto is_letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+	valid = _mm_or_si128(is_digit, is_letter);
+	return _mm_or_si128(
+		_mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+		_mm_and_si128(is_letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)))
+	);
+}
+
+// Pairs of nibbles (high nibble first) in 16-bit lanes to bytes in the low half of the lanes
+inline __m128i combine_nibbles_sse2(__m128i nibbles)
+{
+	return _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4), _mm_srli_epi16(nibbles, 8));
+}
+
+void hex_decode_sse2(const char* hex, std::size_t size, std::uint8_t* data)
+{
+	std::size_t i = 0;
+	for (; i + 16 <= size; i += 16)
+	{
+		__m128i valid_first, valid_second;
+		auto first = hex_to_nibbles_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 2*i)), valid_first);
+		auto second = hex_to_nibbles_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + 2*i + 16)), valid_second);
+		if (_mm_movemask_epi8(_mm_and_si128(valid_first, valid_second)) != 0xFFFF)
+			break;
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_packus_epi16(combine_nibbles_sse2(first), combine_nibbles_sse2(second)));
+	}
+
+	// Remaining bytes and also the block with invalid character so the scalar version reports it
+	hex_decode_scalar(hex + 2*i, size - i, data + i);
+}
+
+#endif
+
+#if defined(CCOOL_HEX_X86) && (defined(__GNUC__) || defined(__clang__))
+#define CCOOL_HEX_AVX2
+
+__attribute__((target("avx2")))
+inline __m256i nibbles_to_hex_avx2(__m256i nibbles)
+{
+	auto letters = _mm256_and_si256(_mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+	return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), letters);
+}
+
+__attribute__((target("avx2")))
+void hex_encode_avx2(const std::uint8_t* data, std::size_t size, char* hex)
+{
+	std::size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		auto high = nibbles_to_hex_avx2(_mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0F)));
+		auto low = nibbles_to_hex_avx2(_mm256_and_si256(bytes, _mm256_set1_epi8(0x0F)));
+
+		// Unpacking works within 128-bit lanes so the halves need to be put back in order
+		auto unpacked_low = _mm256_unpacklo_epi8(high, low);
+		auto unpacked_high = _mm256_unpackhi_epi8(high, low);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(hex + 2*i), _mm256_permute2x128_si256(unpacked_low, unpacked_high, 0x20));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(hex + 2*i + 32), _mm256_permute2x128_si256(unpacked_low, unpacked_high, 0x31));
+	}
+
+	hex_encode_scalar(data + i, size - i, hex + 2*i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i hex_to_nibbles_avx2(__m256i chars, __m256i& valid)
+{
+	auto lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+	auto is_digit = _mm256_andnot_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('9')), _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)));
+	auto is_letter = _mm256_andnot_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('f')), _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)));
+	valid = _mm256_or_si256(is_digit, is_letter);
+	return _mm256_or_si256(
+		_mm256_and_si256(is_digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+		_mm256_and_si256(is_letter, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)))
+	);
+}
+
+__attribute__((target("avx2")))
+inline __m256i combine_nibbles_avx2(__m256i nibbles)
+{
+	return _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00FF)), 4), _mm256_srli_epi16(nibbles, 8));
+}
+
+__attribute__((target("avx2")))
+void hex_decode_avx2(const char* hex, std::size_t size, std::uint8_t* data)
+{
+	std::size_t i = 0;
+	for (; i + 32 <= size; i += 32)
+	{
+		__m256i valid_first, valid_second;
+		auto first = hex_to_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + 2*i)), valid_first);
+		auto second = hex_to_nibbles_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hex + 2*i + 32)), valid_second);
+		if (_mm256_movemask_epi8(_mm256_and_si256(valid_first, valid_second)) != -1)
+			break;
+
+		// Packing works within 128-bit lanes so the quarters need to be put back in order
+		auto packed = _mm256_packus_epi16(combine_nibbles_avx2(first), combine_nibbles_avx2(second));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_permute4x64_epi64(packed, 0xD8));
+	}
+
+	hex_decode_scalar(hex + 2*i, size - i, data + i);
+}
+
+#endif
+
+using HexEncodeFn = void (*)(const std::uint8_t*, std::size_t, char*);
+using HexDecodeFn = void (*)(const char*, std::size_t, std::uint8_t*);
+
+HexEncodeFn select_hex_encode()
+{
+#if defined(CCOOL_HEX_AVX2)
+	if (__builtin_cpu_supports("avx2"))
+		return &hex_encode_avx2;
+#endif
+#if defined(CCOOL_HEX_X86) && defined(__SSE2__)
+	return &hex_encode_sse2;
+#else
+	return &hex_encode_scalar;
+#endif
+}
+
+HexDecodeFn select_hex_decode()
+{
+#if defined(CCOOL_HEX_AVX2)
+	if (__builtin_cpu_supports("avx2"))
+		return &hex_decode_avx2;
+#endif
+#if defined(CCOOL_HEX_X86) && defined(__SSE2__)
+	return &hex_decode_sse2;
+#else
+	return &hex_decode_scalar;
+#endif
+}
+
+} // namespace
+
+void hex_encode_scalar(const std::uint8_t* data, std::size_t size, char* hex)
+{
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hex[2*i] = nibble_to_hex_char(data[i] >> 4);
+		hex[2*i + 1] = nibble_to_hex_char(data[i] & 0x0F);
+	}
+}
+
+void hex_decode_scalar(const char* hex, std::size_t size, std::uint8_t* data)
+{
+	for (std::size_t i = 0; i < size; ++i)
+		data[i] = static_cast<std::uint8_t>((hex_char_to_nibble(hex[2*i]) << 4) | hex_char_to_nibble(hex[2*i + 1]));
+}
+
+void hex_encode(const std::uint8_t* data, std::size_t size, char* hex)
+{
+	static const auto impl = select_hex_encode();
+	impl(data, size, hex);
+}
+
+void hex_decode(const char* hex, std::size_t size, std::uint8_t* data)
+{
+	static const auto impl = select_hex_decode();
+	impl(hex, size, data);
+}
+
+} // namespace ccool
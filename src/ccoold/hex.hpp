@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ccool {
+
+/**
+ * Converts `size` bytes into `2 * size` lowercase hex characters.
+ */
+void hex_encode(const std::uint8_t* data, std::size_t size, char* hex);
+
+/**
+ * Converts `2 * size` hex characters (both lowercase and uppercase) into `size` bytes.
+ * Throws `std::runtime_error` if there is invalid hex character.
+ */
+void hex_decode(const char* hex, std::size_t size, std::uint8_t* data);
+
+// Implementations without any SIMD instructions. Functions above pick the fastest
+// implementation supported by the CPU at runtime.
+void hex_encode_scalar(const std::uint8_t* data, std::size_t size, char* hex);
+void hex_decode_scalar(const char* hex, std::size_t size, std::uint8_t* data);
+
+} // namespace ccool
@@ -5,7 +5,7 @@
 
 namespace ccool {
 
-DebugDeviceInterface::DebugDeviceInterface() : _http_client(::getenv("CCOOLD_DEBUG_DEVICE_INTERFACE_SOCKET"), "debug_device_interface")
+DebugDeviceInterface::DebugDeviceInterface(const std::string& socket_path) : _socket_path(socket_path), _http_client(socket_path, "debug_device_interface")
 {
 }
 
@@ -30,6 +30,16 @@ std::uint32_t DebugDeviceInterface::get_product_id()
 	return response.get_json()["product_id"].get<std::uint32_t>();
 }
 
+std::string DebugDeviceInterface::get_location()
+{
+	return get_location(_socket_path);
+}
+
+std::string DebugDeviceInterface::get_location(const std::string& socket_path)
+{
+	return fmt::format("debug:{}", socket_path);
+}
+
 void DebugDeviceInterface::control(std::uint32_t request_type, std::uint32_t request, std::uint32_t value)
 {
 	auto response = _http_client.send_request("POST", "/control", nlohmann::json{
@@ -49,7 +59,11 @@ void DebugDeviceInterface::send(std::uint8_t endpoint, const Buffer& data)
 Buffer DebugDeviceInterface::recv(std::uint8_t endpoint)
 {
 	auto response = _http_client.send_request("GET", fmt::format("/recv/{}", endpoint));
-	return response.get_json()["data"].get<std::string>();
+	auto hex_string = response.get_json()["data"].get<std::string>();
+
+	auto result = _buffer_pool->acquire(hex_string.size() / 2);
+	result.assign_hex_string(hex_string);
+	return result;
 }
 
 } // namespace ccool
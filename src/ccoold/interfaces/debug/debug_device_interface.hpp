@@ -9,19 +9,23 @@ namespace ccool {
 class DebugDeviceInterface : public DeviceInterface
 {
 public:
-	DebugDeviceInterface();
+	DebugDeviceInterface(const std::string& socket_path);
 	virtual ~DebugDeviceInterface();
 
 	virtual void bind() override;
 
 	virtual std::uint32_t get_vendor_id() override;
 	virtual std::uint32_t get_product_id() override;
+	virtual std::string get_location() override;
+
+	static std::string get_location(const std::string& socket_path);
 
 	virtual void control(std::uint32_t request_type, std::uint32_t request, std::uint32_t value) override;
 	virtual void send(std::uint8_t endpoint, const Buffer& data) override;
 	virtual Buffer recv(std::uint8_t endpoint) override;
 
 private:
+	std::string _socket_path;
 	ulocal::HttpClient _http_client;
 	std::optional<ulocal::HttpResponse> _response;
 };
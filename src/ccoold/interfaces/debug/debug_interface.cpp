@@ -1,22 +1,96 @@
+#include <filesystem>
+#include <unordered_set>
+
 #include <interfaces/debug/debug_interface.hpp>
 #include <interfaces/debug/debug_device_interface.hpp>
 #include <scope_exit.hpp>
+#include <string.hpp>
 
 namespace ccool {
 
-DebugInterface::DebugInterface()
+DebugInterface::DebugInterface() : _socket_paths(), _hotplug_callback(), _watching(false), _watch_thread()
 {
+	// Multiple devices can be emulated by passing colon-separated list of sockets
+	if (auto socket_paths = ::getenv("CCOOLD_DEBUG_DEVICE_INTERFACE_SOCKET"); socket_paths)
+	{
+		for (auto socket_path : split(socket_paths, ':'))
+		{
+			if (!socket_path.empty())
+				_socket_paths.emplace_back(socket_path);
+		}
+	}
 }
 
 DebugInterface::~DebugInterface()
 {
+	if (_watch_thread.joinable())
+	{
+		_watching = false;
+		_watch_thread.join();
+	}
 }
 
 std::vector<std::unique_ptr<DeviceInterface>> DebugInterface::get_device_interfaces()
 {
 	std::vector<std::unique_ptr<DeviceInterface>> result;
-	result.push_back(std::make_unique<DebugDeviceInterface>());
+	for (const auto& socket_path : _socket_paths)
+	{
+		if (std::filesystem::exists(socket_path))
+			result.push_back(std::make_unique<DebugDeviceInterface>(socket_path));
+	}
 	return result;
 }
 
+bool DebugInterface::watch_hotplug(HotplugCallback callback)
+{
+	_hotplug_callback = std::move(callback);
+	_watching = true;
+	_watch_thread = std::thread([this]() {
+		watch_sockets();
+	});
+	return true;
+}
+
+void DebugInterface::watch_sockets()
+{
+	using namespace std::literals;
+
+	// Emulated device is attached when its socket appears and detached when it disappears
+	std::unordered_set<std::string> present;
+	for (const auto& socket_path : _socket_paths)
+	{
+		if (std::filesystem::exists(socket_path))
+			present.insert(socket_path);
+	}
+
+	while (_watching)
+	{
+		std::this_thread::sleep_for(100ms);
+
+		for (const auto& socket_path : _socket_paths)
+		{
+			auto exists = std::filesystem::exists(socket_path);
+			auto was_present = present.find(socket_path) != present.end();
+			if (exists && !was_present)
+			{
+				present.insert(socket_path);
+				_hotplug_callback(HotplugEvent{
+					HotplugEvent::Type::Attached,
+					DebugDeviceInterface::get_location(socket_path),
+					std::make_unique<DebugDeviceInterface>(socket_path)
+				});
+			}
+			else if (!exists && was_present)
+			{
+				present.erase(socket_path);
+				_hotplug_callback(HotplugEvent{
+					HotplugEvent::Type::Detached,
+					DebugDeviceInterface::get_location(socket_path),
+					nullptr
+				});
+			}
+		}
+	}
+}
+
 } // namespace ccool
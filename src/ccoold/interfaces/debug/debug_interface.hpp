@@ -1,5 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <interfaces/device_interface.hpp>
 #include <interfaces/interface.hpp>
 
@@ -12,6 +17,15 @@ public:
 	virtual ~DebugInterface();
 
 	virtual std::vector<std::unique_ptr<DeviceInterface>> get_device_interfaces() override;
+	virtual bool watch_hotplug(HotplugCallback callback) override;
+
+private:
+	void watch_sockets();
+
+	std::vector<std::string> _socket_paths;
+	HotplugCallback _hotplug_callback;
+	std::atomic<bool> _watching;
+	std::thread _watch_thread;
 };
 
 } // namespace ccool
@@ -0,0 +1,56 @@
+#include <interfaces/device_interface.hpp>
+
+namespace ccool {
+
+void DeviceInterface::control_async(std::uint32_t request_type, std::uint32_t request, std::uint32_t value, TransferCallback callback)
+{
+	try
+	{
+		control(request_type, request, value);
+	}
+	catch (...)
+	{
+		callback(std::current_exception(), Buffer{});
+		return;
+	}
+
+	callback(nullptr, Buffer{});
+}
+
+void DeviceInterface::send_async(std::uint8_t endpoint, const Buffer& data, TransferCallback callback)
+{
+	try
+	{
+		send(endpoint, data);
+	}
+	catch (...)
+	{
+		callback(std::current_exception(), Buffer{});
+		return;
+	}
+
+	callback(nullptr, Buffer{});
+}
+
+void DeviceInterface::recv_async(std::uint8_t endpoint, TransferCallback callback)
+{
+	Buffer result;
+	try
+	{
+		result = recv(endpoint);
+	}
+	catch (...)
+	{
+		callback(std::current_exception(), Buffer{});
+		return;
+	}
+
+	callback(nullptr, std::move(result));
+}
+
+void DeviceInterface::wait_for(const std::future<Buffer>& result)
+{
+	result.wait();
+}
+
+} // namespace ccool
@@ -1,25 +1,59 @@
 #pragma once
 
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
 #include <memory>
+#include <string>
 
 #include "buffer.hpp"
+#include "buffer_pool.hpp"
 
 namespace ccool {
 
+/**
+ * Callback invoked once asynchronous transfer is finished. If the transfer failed,
+ * `error` holds the exception which caused it and `data` is empty. Transfers which
+ * do not receive anything always report empty `data`.
+ */
+using TransferCallback = std::function<void(std::exception_ptr error, Buffer data)>;
+
 class DeviceInterface
 {
 public:
+	DeviceInterface() : _buffer_pool(std::make_shared<BufferPool>()) {}
 	virtual ~DeviceInterface() = default;
 
+	// Pool for buffers of the transfers performed through this interface
+	const std::shared_ptr<BufferPool>& get_buffer_pool() const { return _buffer_pool; }
+
 	virtual void bind() = 0;
 
 	virtual std::uint32_t get_vendor_id() = 0;
 	virtual std::uint32_t get_product_id() = 0;
 
+	// Physical location of the device which stays the same even if the device gets
+	// re-enumerated so it can be recognized when it is attached again.
+	virtual std::string get_location() = 0;
+
 	virtual void control(std::uint32_t request_type, std::uint32_t request, std::uint32_t value) = 0;
 	virtual void send(std::uint8_t endpoint, const Buffer& data) = 0;
 	virtual Buffer recv(std::uint8_t endpoint) = 0;
+
+	// Asynchronous variants of the transfers above. Interfaces without any native
+	// support for asynchronous transfers perform them synchronously and invoke
+	// the callback before returning.
+	virtual void control_async(std::uint32_t request_type, std::uint32_t request, std::uint32_t value, TransferCallback callback);
+	virtual void send_async(std::uint8_t endpoint, const Buffer& data, TransferCallback callback);
+	virtual void recv_async(std::uint8_t endpoint, TransferCallback callback);
+
+	// Blocks until the result of asynchronous transfer is ready. Interfaces which need
+	// the waiting thread to help with processing of the transfer events override this.
+	virtual void wait_for(const std::future<Buffer>& result);
+
+protected:
+	std::shared_ptr<BufferPool> _buffer_pool;
 };
 
 } // namespace ccool
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -8,6 +9,24 @@
 
 namespace ccool {
 
+class EventLoop;
+
+struct HotplugEvent
+{
+	enum class Type
+	{
+		Attached,
+		Detached
+	};
+
+	Type type;
+	std::string location;
+	// Only set for attached devices
+	std::unique_ptr<DeviceInterface> device_interface;
+};
+
+using HotplugCallback = std::function<void(HotplugEvent&& event)>;
+
 class Interface
 {
 public:
@@ -17,6 +36,19 @@ public:
 	static std::unique_ptr<Interface> create(const std::string& name);
 
 	virtual std::vector<std::unique_ptr<DeviceInterface>> get_device_interfaces() = 0;
+
+	/**
+	 * Starts reporting devices which get attached or detached at runtime. Callback can be
+	 * invoked from any thread and should not perform any I/O with the device itself.
+	 * Returns false if the interface does not support hotplug.
+	 */
+	virtual bool watch_hotplug(HotplugCallback/* callback*/) { return false; }
+
+	/**
+	 * Lets the interface process its events in the given event loop instead of doing it
+	 * on its own. Event loop needs to outlive the interface.
+	 */
+	virtual void use_event_loop(EventLoop&/* loop*/) {}
 };
 
 } // namespace ccool
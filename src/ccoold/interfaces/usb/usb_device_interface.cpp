@@ -1,10 +1,18 @@
+#include <array>
+#include <future>
+
+#include <fmt/format.h>
+
 #include <interfaces/usb/usb_device_interface.hpp>
+#include <interfaces/usb/usb_transfer.hpp>
 
 namespace ccool {
 
-UsbDeviceInterface::UsbDeviceInterface(libusb_device* device) : _device(device), _device_desc(), _handle(nullptr),
+UsbDeviceInterface::UsbDeviceInterface(libusb_context* context, libusb_device* device) : _context(context), _device(device), _device_desc(), _handle(nullptr),
 	_reattach_kernel_driver(false), _release_interface(false), _endpoint_mtu()
 {
+	// Device list is freed right after the detection so we need to hold our own reference
+	libusb_ref_device(_device);
 	libusb_get_device_descriptor(_device, &_device_desc);
 }
 
@@ -19,6 +27,8 @@ UsbDeviceInterface::~UsbDeviceInterface()
 		libusb_close(_handle);
 		_handle = nullptr;
 	}
+
+	libusb_unref_device(_device);
 }
 
 void UsbDeviceInterface::bind()
@@ -77,63 +87,94 @@ std::uint32_t UsbDeviceInterface::get_product_id()
 	return _device_desc.idProduct;
 }
 
-void UsbDeviceInterface::control(std::uint32_t request_type, std::uint32_t request, std::uint32_t value)
+std::string UsbDeviceInterface::get_location()
 {
-	auto ret = libusb_control_transfer(
-		_handle,
-		request_type,
-		request,
-		value,
-		0,
-		nullptr,
-		0,
-		5000
-	);
+	return get_location(_device);
+}
 
-	// We seems to need to allow ERROR_PIPE as OK because
-	// some control requests end with this request but
-	// everything seems to be fine.
-	if (ret != 0 && ret != LIBUSB_ERROR_PIPE)
-		throw std::runtime_error("Unable to send control command to UsbDeviceInterface");
+std::string UsbDeviceInterface::get_location(libusb_device* device)
+{
+	// Bus and port path stay the same when the device is re-enumerated, its address does not
+	std::array<std::uint8_t, 7> port_numbers;
+	auto port_count = libusb_get_port_numbers(device, port_numbers.data(), static_cast<int>(port_numbers.size()));
+	if (port_count < 0)
+		port_count = 0;
+
+	return fmt::format("usb:{}-{}", libusb_get_bus_number(device), fmt::join(port_numbers.begin(), port_numbers.begin() + port_count, "."));
 }
 
-void UsbDeviceInterface::send(std::uint8_t endpoint, const Buffer& data)
+template <typename Fn>
+Buffer UsbDeviceInterface::wait_for_transfer(Fn&& submit)
 {
-	int sent = 0;
-	int bytes_to_send = static_cast<int>(std::min(data.get_size(), get_endpoint_mtu(endpoint)));
+	auto promise = std::make_shared<std::promise<Buffer>>();
+	auto result = promise->get_future();
+
+	submit([promise](std::exception_ptr error, Buffer data) {
+		if (error)
+			promise->set_exception(error);
+		else
+			promise->set_value(std::move(data));
+	});
+
+	wait_for(result);
+	return result.get();
+}
 
-	auto ret = libusb_bulk_transfer(
-		_handle,
-		LIBUSB_ENDPOINT_OUT | endpoint,
-		const_cast<std::uint8_t*>(data.get_raw_data()),
-		bytes_to_send,
-		&sent,
-		5000
-	);
+void UsbDeviceInterface::control(std::uint32_t request_type, std::uint32_t request, std::uint32_t value)
+{
+	wait_for_transfer([&](auto&& callback) {
+		control_async(request_type, request, value, std::move(callback));
+	});
+}
 
-	if (ret != 0)
-		throw std::runtime_error("Unable to send data to UsbDeviceInterface");
+void UsbDeviceInterface::send(std::uint8_t endpoint, const Buffer& data)
+{
+	wait_for_transfer([&](auto&& callback) {
+		send_async(endpoint, data, std::move(callback));
+	});
 }
 
 Buffer UsbDeviceInterface::recv(std::uint8_t endpoint)
 {
-	Buffer result(get_endpoint_mtu(endpoint));
-	int read = 0;
+	return wait_for_transfer([&](auto&& callback) {
+		recv_async(endpoint, std::move(callback));
+	});
+}
+
+void UsbDeviceInterface::wait_for(const std::future<Buffer>& result)
+{
+	using namespace std::literals;
 
-	auto ret = libusb_bulk_transfer(
+	// Transfer events might be processed by the event loop which can itself be waiting for us
+	// so we process them too while waiting. libusb makes sure that only one thread does it at
+	// a time and wakes up the others once it is done so we can check whether we got our result.
+	while (result.wait_for(0s) != std::future_status::ready)
+	{
+		timeval timeout = {0, 100000};
+		libusb_handle_events_timeout_completed(_context, &timeout, nullptr);
+	}
+}
+
+void UsbDeviceInterface::control_async(std::uint32_t request_type, std::uint32_t request, std::uint32_t value, TransferCallback callback)
+{
+	UsbTransfer::submit_control(
 		_handle,
-		LIBUSB_ENDPOINT_IN | endpoint,
-		result.get_raw_data(),
-		result.get_size(),
-		&read,
-		5000
+		static_cast<std::uint8_t>(request_type),
+		static_cast<std::uint8_t>(request),
+		static_cast<std::uint16_t>(value),
+		std::move(callback)
 	);
+}
 
-	if (ret != 0)
-		throw std::runtime_error("Unable to receive data from UsbDeviceInterface");
+void UsbDeviceInterface::send_async(std::uint8_t endpoint, const Buffer& data, TransferCallback callback)
+{
+	auto to_send = _buffer_pool->acquire(data.get_data().substr(0, get_endpoint_mtu(endpoint)));
+	UsbTransfer::submit_bulk(_handle, LIBUSB_ENDPOINT_OUT | endpoint, std::move(to_send), std::move(callback));
+}
 
-	result.resize(read);
-	return result;
+void UsbDeviceInterface::recv_async(std::uint8_t endpoint, TransferCallback callback)
+{
+	UsbTransfer::submit_bulk(_handle, LIBUSB_ENDPOINT_IN | endpoint, _buffer_pool->acquire(get_endpoint_mtu(endpoint)), std::move(callback));
 }
 
 std::size_t UsbDeviceInterface::get_endpoint_mtu(std::uint8_t endpoint)
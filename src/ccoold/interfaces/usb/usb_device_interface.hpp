@@ -11,21 +11,34 @@ namespace ccool {
 class UsbDeviceInterface : public DeviceInterface
 {
 public:
-	UsbDeviceInterface(libusb_device* device);
+	UsbDeviceInterface(libusb_context* context, libusb_device* device);
 	virtual ~UsbDeviceInterface();
 
 	virtual void bind() override;
 
 	virtual std::uint32_t get_vendor_id() override;
 	virtual std::uint32_t get_product_id() override;
+	virtual std::string get_location() override;
+
+	static std::string get_location(libusb_device* device);
 
 	virtual void control(std::uint32_t request_type, std::uint32_t request, std::uint32_t value) override;
 	virtual void send(std::uint8_t endpoint, const Buffer& data) override;
 	virtual Buffer recv(std::uint8_t endpoint) override;
 
+	virtual void control_async(std::uint32_t request_type, std::uint32_t request, std::uint32_t value, TransferCallback callback) override;
+	virtual void send_async(std::uint8_t endpoint, const Buffer& data, TransferCallback callback) override;
+	virtual void recv_async(std::uint8_t endpoint, TransferCallback callback) override;
+
+	virtual void wait_for(const std::future<Buffer>& result) override;
+
 private:
+	template <typename Fn>
+	Buffer wait_for_transfer(Fn&& submit);
+
 	std::size_t get_endpoint_mtu(std::uint8_t endpoint);
 
+	libusb_context* _context;
 	libusb_device* _device;
 	libusb_device_descriptor _device_desc;
 	libusb_device_handle* _handle;
@@ -1,16 +1,45 @@
+#include <event_loop.hpp>
 #include <interfaces/usb/usb_interface.hpp>
 #include <interfaces/usb/usb_device_interface.hpp>
 #include <scope_exit.hpp>
 
 namespace ccool {
 
-UsbInterface::UsbInterface()
+UsbInterface::UsbInterface() : _context(nullptr), _hotplug_handle(), _hotplug_callback(), _handling_events(false), _event_thread(),
+	_event_loop(nullptr), _pollfds_mutex(), _pollfds()
 {
-	libusb_init(&_context);
+	if (libusb_init(&_context) != 0)
+	{
+		_context = nullptr;
+		return;
+	}
+
+	_handling_events = true;
+	_event_thread = std::thread([this]() {
+		handle_events();
+	});
 }
 
 UsbInterface::~UsbInterface()
 {
+	if (_hotplug_handle)
+	{
+		libusb_hotplug_deregister_callback(_context, _hotplug_handle.value());
+		_hotplug_handle = std::nullopt;
+	}
+
+	stop_event_thread();
+
+	if (_event_loop)
+	{
+		libusb_set_pollfd_notifiers(_context, nullptr, nullptr, nullptr);
+
+		std::lock_guard lock(_pollfds_mutex);
+		for (auto fd : _pollfds)
+			_event_loop->remove_fd(fd);
+		_pollfds.clear();
+	}
+
 	if (_context)
 	{
 		libusb_exit(_context);
@@ -20,6 +49,9 @@ UsbInterface::~UsbInterface()
 
 std::vector<std::unique_ptr<DeviceInterface>> UsbInterface::get_device_interfaces()
 {
+	if (!_context)
+		return {};
+
 	libusb_device** device_list;
 	auto device_count = libusb_get_device_list(_context, &device_list);
 	if (device_count < 0)
@@ -31,9 +63,130 @@ std::vector<std::unique_ptr<DeviceInterface>> UsbInterface::get_device_interface
 
 	std::vector<std::unique_ptr<DeviceInterface>> result;
 	for (decltype(device_count) i = 0; i < device_count; ++i)
-		result.emplace_back(std::make_unique<UsbDeviceInterface>(device_list[i]));
+		result.emplace_back(std::make_unique<UsbDeviceInterface>(_context, device_list[i]));
 
 	return result;
 }
 
+bool UsbInterface::watch_hotplug(HotplugCallback callback)
+{
+	if (!_context || !libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG))
+		return false;
+
+	_hotplug_callback = std::move(callback);
+
+	libusb_hotplug_callback_handle handle;
+	auto result = libusb_hotplug_register_callback(
+		_context,
+		LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+		LIBUSB_HOTPLUG_NO_FLAGS,
+		LIBUSB_HOTPLUG_MATCH_ANY,
+		LIBUSB_HOTPLUG_MATCH_ANY,
+		LIBUSB_HOTPLUG_MATCH_ANY,
+		&UsbInterface::on_hotplug,
+		this,
+		&handle
+	);
+	if (result != LIBUSB_SUCCESS)
+	{
+		_hotplug_callback = nullptr;
+		return false;
+	}
+
+	_hotplug_handle = handle;
+	return true;
+}
+
+int LIBUSB_CALL UsbInterface::on_hotplug(libusb_context*/* context*/, libusb_device* device, libusb_hotplug_event event, void* user_data)
+{
+	auto* self = static_cast<UsbInterface*>(user_data);
+
+	// We are on the event handling thread so we can't do any I/O with the device here,
+	// that is left up to whoever receives the event
+	if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED)
+		self->_hotplug_callback(HotplugEvent{
+			HotplugEvent::Type::Attached,
+			UsbDeviceInterface::get_location(device),
+			std::make_unique<UsbDeviceInterface>(self->_context, device)
+		});
+	else if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT)
+		self->_hotplug_callback(HotplugEvent{
+			HotplugEvent::Type::Detached,
+			UsbDeviceInterface::get_location(device),
+			nullptr
+		});
+
+	// Keep the callback registered
+	return 0;
+}
+
+void UsbInterface::use_event_loop(EventLoop& loop)
+{
+	// Without timerfd support, libusb would need us to track timeouts of the transfers ourselves
+	if (!_context || !libusb_pollfds_handle_timeouts(_context))
+		return;
+
+	stop_event_thread();
+	_event_loop = &loop;
+
+	libusb_set_pollfd_notifiers(_context, &UsbInterface::on_pollfd_added, &UsbInterface::on_pollfd_removed, this);
+
+	auto* pollfds = libusb_get_pollfds(_context);
+	for (auto* pollfd = pollfds; pollfd && *pollfd; ++pollfd)
+		watch_pollfd((*pollfd)->fd, (*pollfd)->events);
+	libusb_free_pollfds(pollfds);
+}
+
+void UsbInterface::stop_event_thread()
+{
+	if (_event_thread.joinable())
+	{
+		_handling_events = false;
+		libusb_interrupt_event_handler(_context);
+		_event_thread.join();
+	}
+}
+
+void UsbInterface::watch_pollfd(int fd, short events)
+{
+	{
+		std::lock_guard lock(_pollfds_mutex);
+		_pollfds.insert(fd);
+	}
+
+	// Zero timeout only processes what is already there without waiting for anything else
+	_event_loop->add_fd(fd, static_cast<std::uint32_t>(events), [this](std::uint32_t) {
+		timeval timeout = {0, 0};
+		libusb_handle_events_timeout_completed(_context, &timeout, nullptr);
+	});
+}
+
+void LIBUSB_CALL UsbInterface::on_pollfd_added(int fd, short events, void* user_data)
+{
+	static_cast<UsbInterface*>(user_data)->watch_pollfd(fd, events);
+}
+
+void LIBUSB_CALL UsbInterface::on_pollfd_removed(int fd, void* user_data)
+{
+	auto* self = static_cast<UsbInterface*>(user_data);
+
+	{
+		std::lock_guard lock(self->_pollfds_mutex);
+		self->_pollfds.erase(fd);
+	}
+
+	self->_event_loop->remove_fd(fd);
+}
+
+void UsbInterface::handle_events()
+{
+	// Completion callbacks of all asynchronous transfers are run from here.
+	// Timeout is there only so we periodically check whether we should stop.
+	while (_handling_events)
+	{
+		timeval timeout = {1, 0};
+		libusb_handle_events_timeout_completed(_context, &timeout, nullptr);
+	}
+}
+
 } // namespace ccool
@@ -1,5 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
 #include <libusb-1.0/libusb.h>
 
 #include <interfaces/device_interface.hpp>
@@ -14,9 +20,27 @@ public:
 	virtual ~UsbInterface();
 
 	virtual std::vector<std::unique_ptr<DeviceInterface>> get_device_interfaces() override;
+	virtual bool watch_hotplug(HotplugCallback callback) override;
+	virtual void use_event_loop(EventLoop& loop) override;
 
 private:
+	void handle_events();
+	void stop_event_thread();
+	void watch_pollfd(int fd, short events);
+
+	static void LIBUSB_CALL on_pollfd_added(int fd, short events, void* user_data);
+	static void LIBUSB_CALL on_pollfd_removed(int fd, void* user_data);
+
+	static int LIBUSB_CALL on_hotplug(libusb_context* context, libusb_device* device, libusb_hotplug_event event, void* user_data);
+
 	libusb_context* _context;
+	std::optional<libusb_hotplug_callback_handle> _hotplug_handle;
+	HotplugCallback _hotplug_callback;
+	std::atomic<bool> _handling_events;
+	std::thread _event_thread;
+	EventLoop* _event_loop;
+	std::mutex _pollfds_mutex;
+	std::unordered_set<int> _pollfds;
 };
 
 } // namespace ccool
@@ -0,0 +1,89 @@
+#include <stdexcept>
+
+#include <interfaces/usb/usb_transfer.hpp>
+
+namespace ccool {
+
+UsbTransfer::UsbTransfer(Buffer&& data, TransferCallback&& callback) : _transfer(libusb_alloc_transfer(0)), _data(std::move(data)), _callback(std::move(callback))
+{
+}
+
+UsbTransfer::~UsbTransfer()
+{
+	if (_transfer)
+	{
+		libusb_free_transfer(_transfer);
+		_transfer = nullptr;
+	}
+}
+
+void UsbTransfer::submit_control(libusb_device_handle* handle, std::uint8_t request_type, std::uint8_t request, std::uint16_t value, TransferCallback callback)
+{
+	auto* transfer = new UsbTransfer(Buffer(LIBUSB_CONTROL_SETUP_SIZE), std::move(callback));
+	if (!transfer->_transfer)
+		return transfer->complete(std::make_exception_ptr(std::runtime_error("Unable to allocate USB transfer")));
+
+	libusb_fill_control_setup(transfer->_data.get_raw_data(), request_type, request, value, 0, 0);
+	libusb_fill_control_transfer(transfer->_transfer, handle, transfer->_data.get_raw_data(), &UsbTransfer::on_completed, transfer, Timeout);
+	transfer->submit();
+}
+
+void UsbTransfer::submit_bulk(libusb_device_handle* handle, std::uint8_t endpoint, Buffer&& data, TransferCallback callback)
+{
+	auto* transfer = new UsbTransfer(std::move(data), std::move(callback));
+	if (!transfer->_transfer)
+		return transfer->complete(std::make_exception_ptr(std::runtime_error("Unable to allocate USB transfer")));
+
+	libusb_fill_bulk_transfer(
+		transfer->_transfer,
+		handle,
+		endpoint,
+		transfer->_data.get_raw_data(),
+		static_cast<int>(transfer->_data.get_size()),
+		&UsbTransfer::on_completed,
+		transfer,
+		Timeout
+	);
+	transfer->submit();
+}
+
+void UsbTransfer::submit()
+{
+	if (libusb_submit_transfer(_transfer) != 0)
+		complete(std::make_exception_ptr(std::runtime_error("Unable to submit USB transfer")));
+}
+
+void UsbTransfer::complete(std::exception_ptr error)
+{
+	auto callback = std::move(_callback);
+	auto data = error ? Buffer{} : std::move(_data);
+	delete this;
+
+	callback(error, std::move(data));
+}
+
+void LIBUSB_CALL UsbTransfer::on_completed(libusb_transfer* transfer)
+{
+	auto* self = static_cast<UsbTransfer*>(transfer->user_data);
+	auto is_control = transfer->type == LIBUSB_TRANSFER_TYPE_CONTROL;
+
+	// Same as with synchronous control transfers, some control requests
+	// end up stalled but the device still behaves correctly.
+	if (transfer->status != LIBUSB_TRANSFER_COMPLETED && !(is_control && transfer->status == LIBUSB_TRANSFER_STALL))
+	{
+		self->complete(std::make_exception_ptr(std::runtime_error(transfer->status == LIBUSB_TRANSFER_TIMED_OUT
+			? "USB transfer timed out"
+			: "USB transfer failed"
+		)));
+		return;
+	}
+
+	if (is_control || !(transfer->endpoint & LIBUSB_ENDPOINT_IN))
+		self->_data = Buffer{};
+	else
+		self->_data.resize(static_cast<std::size_t>(transfer->actual_length));
+
+	self->complete(nullptr);
+}
+
+} // namespace ccool
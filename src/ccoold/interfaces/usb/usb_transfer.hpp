@@ -0,0 +1,41 @@
+#pragma once
+
+#include <libusb-1.0/libusb.h>
+
+#include <interfaces/device_interface.hpp>
+
+namespace ccool {
+
+/**
+ * Single asynchronous libusb transfer. The transfer owns its data buffer and
+ * releases itself once completed after the callback has been invoked. Callbacks
+ * are invoked from the thread handling libusb events.
+ */
+class UsbTransfer
+{
+public:
+	static constexpr unsigned int Timeout = 5000;
+
+	static void submit_control(libusb_device_handle* handle, std::uint8_t request_type, std::uint8_t request, std::uint16_t value, TransferCallback callback);
+	static void submit_bulk(libusb_device_handle* handle, std::uint8_t endpoint, Buffer&& data, TransferCallback callback);
+
+private:
+	UsbTransfer(Buffer&& data, TransferCallback&& callback);
+	UsbTransfer(const UsbTransfer&) = delete;
+	UsbTransfer(UsbTransfer&&) noexcept = delete;
+	~UsbTransfer();
+
+	UsbTransfer& operator=(const UsbTransfer&) = delete;
+	UsbTransfer& operator=(UsbTransfer&&) noexcept = delete;
+
+	void submit();
+	void complete(std::exception_ptr error);
+
+	static void LIBUSB_CALL on_completed(libusb_transfer* transfer);
+
+	libusb_transfer* _transfer;
+	Buffer _data;
+	TransferCallback _callback;
+};
+
+} // namespace ccool
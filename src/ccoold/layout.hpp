@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "buffer_reader.hpp"
+#include "endian.hpp"
+#include "fixed_point.hpp"
+
+namespace ccool {
+
+/**
+ * Loads and stores of message fields at fixed offsets of message images. Offsets are known
+ * at compile time (generated by dpgen) and the size of the image is checked once for the whole
+ * message, so there are no bounds checks here and fields are loaded through `BufferReader`.
+ */
+template <Endian E, typename T>
+T load_field(const std::uint8_t* data)
+{
+	return BufferReader<E>{data}.template read<T>();
+}
+
+template <Endian E, typename T>
+void load_array_field(const std::uint8_t* data, std::span<T> values)
+{
+	BufferReader<E>{data}.template read_array<T>(values);
+}
+
+template <Endian E, typename T>
+std::vector<T> load_array_field(const std::uint8_t* data, std::size_t count)
+{
+	std::vector<T> result(count);
+	load_array_field<E, T>(data, std::span<T>{result});
+	return result;
+}
+
+template <Endian E, typename T>
+void store_field(std::uint8_t* data, const T& value)
+{
+	if constexpr (std::is_integral_v<T>)
+	{
+		auto value_ce = endian_convert<Endian::Native, E>(value);
+		std::memcpy(data, &value_ce, sizeof(T));
+	}
+	else
+		store_field<E, typename T::UnderlyingType>(data, value.data());
+}
+
+template <Endian E, typename T>
+void store_array_field(std::uint8_t* data, std::span<const T> values)
+{
+	if constexpr (sizeof(T) == 1)
+		std::memcpy(data, values.data(), values.size());
+	else
+	{
+		for (std::size_t i = 0; i < values.size(); ++i)
+			store_field<E, T>(data + i * sizeof(T), values[i]);
+	}
+}
+
+} // namespace ccool
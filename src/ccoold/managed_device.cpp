@@ -0,0 +1,245 @@
+#include <spdlog/spdlog.h>
+
+#include "logging.hpp"
+#include "managed_device.hpp"
+
+namespace ccool {
+
+ManagedDevice::ManagedDevice(std::uint32_t id, std::unique_ptr<BaseDevice>&& device, std::chrono::milliseconds sample_interval)
+	: _id(id), _name(device->get_name()), _location(device->get_location()), _fan_count(device->get_fan_count()),
+	_telemetry(), _history(_fan_count), _pump_rpm_read(), _fans_rpm_read(), _temperature_read(), _snapshot_read(), _sensors_read(),
+	_sampler([this]() { return read_sensors(); }, sample_interval), _mutex(), _settings(), _applied(), _pump_writes(), _fans_writes(), _worker(), _buffer_pool()
+{
+	attach(std::move(device));
+}
+
+ManagedDevice::~ManagedDevice()
+{
+	detach();
+}
+
+bool ManagedDevice::is_attached() const
+{
+	std::lock_guard lock(_mutex);
+	return _worker != nullptr;
+}
+
+void ManagedDevice::attach(std::unique_ptr<BaseDevice>&& device)
+{
+	auto buffer_pool = device->get_buffer_pool();
+	auto worker = std::make_shared<DeviceWorker>(std::move(device));
+
+	std::lock_guard lock(_mutex);
+	if (!_settings.empty())
+	{
+		// Restoring goes first so nothing else gets to the device while it runs on firmware defaults
+		worker->submit([this, settings = _settings](BaseDevice& device) {
+			try
+			{
+				settings.apply(device);
+				LOG->info("Restored settings of device {}", _id);
+
+				std::lock_guard lock(_mutex);
+				_applied = settings;
+			}
+			catch (const std::exception& error)
+			{
+				LOG->warn("Failed to restore settings of device {}: {}", _id, error.what());
+			}
+		});
+	}
+
+	// Device runs on firmware defaults until the settings are restored
+	_applied = DeviceSettings{};
+	_worker = std::move(worker);
+	_buffer_pool = std::move(buffer_pool);
+}
+
+void ManagedDevice::detach()
+{
+	// Worker is stopped outside of the lock since its remaining commands may need it
+	std::shared_ptr<DeviceWorker> worker;
+	{
+		std::lock_guard lock(_mutex);
+		worker = std::move(_worker);
+	}
+	worker.reset();
+
+	// Readings of detached device are not valid anymore, also those taken by the remaining commands
+	_telemetry.reset();
+}
+
+template <typename T, typename Fn>
+std::future<void> ManagedDevice::write_setting(WriteChannel& channel, T DeviceSettings::* setting, T value, Fn&& write)
+{
+	auto generation = ++channel.generation;
+	return submit([this, &channel, setting, generation, value = std::move(value), write = std::forward<Fn>(write)](BaseDevice& device) {
+		// Newer write to the same channel is already queued and it is going to replace this one
+		if (generation != channel.generation)
+		{
+			++channel.merged;
+			return;
+		}
+
+		{
+			std::lock_guard lock(_mutex);
+			if (_applied.*setting == value)
+			{
+				++channel.suppressed;
+				return;
+			}
+		}
+
+		try
+		{
+			write(device);
+		}
+		catch (...)
+		{
+			// Write might have been only partially successful so the state of the device is unknown
+			std::lock_guard lock(_mutex);
+			_applied.*setting = T{};
+			throw;
+		}
+
+		++channel.issued;
+
+		std::lock_guard lock(_mutex);
+		_settings.*setting = value;
+		_applied.*setting = value;
+	});
+}
+
+std::future<void> ManagedDevice::write_pump_mode(std::uint8_t mode)
+{
+	return write_setting(_pump_writes, &DeviceSettings::pump_mode, std::optional<std::uint8_t>{mode}, [mode](BaseDevice& device) {
+		device.write_pump_mode(mode);
+	});
+}
+
+std::future<void> ManagedDevice::write_fans_pwm(std::uint8_t pwm)
+{
+	return write_setting(_fans_writes, &DeviceSettings::fans, FansSetting{FansPwm{pwm}}, [pwm](BaseDevice& device) {
+		device.write_fans_pwm(pwm);
+	});
+}
+
+std::future<void> ManagedDevice::write_fans_rpm(std::uint16_t rpm)
+{
+	return write_setting(_fans_writes, &DeviceSettings::fans, FansSetting{FansRpm{rpm}}, [rpm](BaseDevice& device) {
+		device.write_fans_rpm(rpm);
+	});
+}
+
+std::future<void> ManagedDevice::write_fans_curve(const FansCurve& curve)
+{
+	return write_setting(_fans_writes, &DeviceSettings::fans, FansSetting{curve}, [curve](BaseDevice& device) {
+		device.write_fans_curve(curve.get_temperatures(), curve.get_pwms());
+	});
+}
+
+std::shared_future<std::uint16_t> ManagedDevice::read_pump_rpm()
+{
+	return _pump_rpm_read.run([this]() {
+		return submit([this](BaseDevice& device) {
+			auto pump_rpm = device.read_pump_rpm();
+			_telemetry.pump_rpm.update(pump_rpm);
+			_history.record_pump_rpm(pump_rpm);
+			return pump_rpm;
+		});
+	});
+}
+
+std::shared_future<std::vector<std::uint16_t>> ManagedDevice::read_fans_rpm()
+{
+	return _fans_rpm_read.run([this]() {
+		return submit([this](BaseDevice& device) {
+			auto fans_rpm = device.read_fans_rpm();
+			_telemetry.fans_rpm.update(fans_rpm);
+			_history.record_fans_rpm(fans_rpm);
+			return fans_rpm;
+		});
+	});
+}
+
+std::shared_future<FixedPoint<16>> ManagedDevice::read_temperature()
+{
+	return _temperature_read.run([this]() {
+		return submit([this](BaseDevice& device) {
+			auto temperature = device.read_temperature();
+			_telemetry.temperature.update(temperature);
+			_history.record_temperature(temperature);
+			return temperature;
+		});
+	});
+}
+
+std::shared_future<SensorSnapshot> ManagedDevice::read_snapshot()
+{
+	return _snapshot_read.run([this]() {
+		return submit([this](BaseDevice& device) {
+			return take_snapshot(device);
+		});
+	});
+}
+
+std::shared_future<void> ManagedDevice::read_sensors()
+{
+	return _sensors_read.run([this]() {
+		return submit([this](BaseDevice& device) {
+			try
+			{
+				take_snapshot(device);
+			}
+			catch (const std::exception& error)
+			{
+				LOG->warn("Failed to sample sensors of device {}: {}", _id, error.what());
+			}
+		});
+	});
+}
+
+Clock::time_point ManagedDevice::poll_sampler()
+{
+	if (!is_attached())
+		return Clock::time_point::max();
+
+	return _sampler.poll();
+}
+
+BufferPoolStats ManagedDevice::get_buffer_pool_stats() const
+{
+	std::lock_guard lock(_mutex);
+	return _buffer_pool ? _buffer_pool->get_stats() : BufferPoolStats{};
+}
+
+SensorSnapshot ManagedDevice::take_snapshot(BaseDevice& device)
+{
+	auto snapshot = device.read_snapshot();
+
+	auto fans_rpm = snapshot.get_fans_rpm();
+	auto fans_rpm_values = std::vector<std::uint16_t>(fans_rpm.begin(), fans_rpm.end());
+
+	auto now = Clock::now();
+	_telemetry.pump_rpm.update(snapshot.pump_rpm, now);
+	_telemetry.fans_rpm.update(fans_rpm_values, now);
+	_telemetry.temperature.update(snapshot.temperature, now);
+
+	auto time = SystemClock::now();
+	_history.record_pump_rpm(snapshot.pump_rpm, time);
+	_history.record_fans_rpm(fans_rpm_values, time);
+	_history.record_temperature(snapshot.temperature, time);
+	LOG->trace("Sampled sensors of device {} (pump={}, fans=[{}], temperature={})", _id, snapshot.pump_rpm, fmt::join(fans_rpm, ", "), snapshot.temperature.floating());
+	return snapshot;
+}
+
+std::shared_ptr<DeviceWorker> ManagedDevice::get_worker() const
+{
+	std::lock_guard lock(_mutex);
+	if (!_worker)
+		throw DeviceDetachedError{};
+
+	return _worker;
+}
+
+} // namespace ccool
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#include "device.hpp"
+#include "device_settings.hpp"
+#include "device_worker.hpp"
+#include "sensor_sampler.hpp"
+#include "single_flight.hpp"
+#include "telemetry.hpp"
+#include "telemetry_history.hpp"
+
+namespace ccool {
+
+class DeviceDetachedError : public std::runtime_error
+{
+public:
+	DeviceDetachedError() : std::runtime_error("Device is detached") {}
+};
+
+struct WriteStats
+{
+	std::uint64_t issued;
+	std::uint64_t suppressed;
+	std::uint64_t merged;
+};
+
+/**
+ * Device driven by the daemon together with everything that belongs to it.
+ * Each device has its own worker thread so multiple devices are accessed
+ * in parallel.
+ *
+ * Managed device outlives the physical device. When the device is detached, its worker
+ * is stopped and once the same device is attached again at the same location, the settings
+ * last written to it are restored before anything else is done with it.
+ *
+ * Writes are skipped if the device already has the requested setting (suppressed) or if
+ * another write to the same channel was queued after them and would overwrite them anyway (merged).
+ */
+class ManagedDevice
+{
+public:
+	ManagedDevice(std::uint32_t id, std::unique_ptr<BaseDevice>&& device, std::chrono::milliseconds sample_interval);
+	ManagedDevice(const ManagedDevice&) = delete;
+	ManagedDevice(ManagedDevice&&) noexcept = delete;
+	~ManagedDevice();
+
+	ManagedDevice& operator=(const ManagedDevice&) = delete;
+	ManagedDevice& operator=(ManagedDevice&&) noexcept = delete;
+
+	std::uint32_t get_id() const { return _id; }
+	const std::string& get_name() const { return _name; }
+	const std::string& get_location() const { return _location; }
+	std::uint32_t get_fan_count() const { return _fan_count; }
+	TelemetryStore& get_telemetry() { return _telemetry; }
+	const TelemetryHistory& get_history() const { return _history; }
+
+	bool is_attached() const;
+	void attach(std::unique_ptr<BaseDevice>&& device);
+	void detach();
+
+	/**
+	 * Submits command to the worker of the device. Throws `DeviceDetachedError` if the device is detached.
+	 */
+	template <typename Fn>
+	std::future<std::invoke_result_t<Fn, BaseDevice&>> submit(Fn&& fn)
+	{
+		return get_worker()->submit(std::forward<Fn>(fn));
+	}
+
+	// Writes which are remembered so they can be restored. Redundant writes are not sent to the device.
+	std::future<void> write_pump_mode(std::uint8_t mode);
+	std::future<void> write_fans_pwm(std::uint8_t pwm);
+	std::future<void> write_fans_rpm(std::uint16_t rpm);
+	std::future<void> write_fans_curve(const FansCurve& curve);
+
+	// Reads which also update the telemetry store. Concurrent reads of the same
+	// sensor share single pending read instead of each of them going to the device.
+	std::shared_future<std::uint16_t> read_pump_rpm();
+	std::shared_future<std::vector<std::uint16_t>> read_fans_rpm();
+	std::shared_future<FixedPoint<16>> read_temperature();
+	std::shared_future<SensorSnapshot> read_snapshot();
+
+	/**
+	 * Reads all sensors at once into the telemetry store. Errors are only logged so
+	 * the returned future never holds an exception.
+	 */
+	std::shared_future<void> read_sensors();
+
+	WriteStats get_pump_write_stats() const { return _pump_writes.get_stats(); }
+	WriteStats get_fans_write_stats() const { return _fans_writes.get_stats(); }
+	BufferPoolStats get_buffer_pool_stats() const;
+
+	/**
+	 * Samples sensors if the next sample is due. Returns time point of the next sample.
+	 */
+	Clock::time_point poll_sampler();
+
+private:
+	struct WriteChannel
+	{
+		std::atomic<std::uint64_t> generation = 0;
+		std::atomic<std::uint64_t> issued = 0;
+		std::atomic<std::uint64_t> suppressed = 0;
+		std::atomic<std::uint64_t> merged = 0;
+
+		WriteStats get_stats() const { return {issued, suppressed, merged}; }
+	};
+
+	template <typename T, typename Fn>
+	std::future<void> write_setting(WriteChannel& channel, T DeviceSettings::* setting, T value, Fn&& write);
+
+	std::shared_ptr<DeviceWorker> get_worker() const;
+	SensorSnapshot take_snapshot(BaseDevice& device);
+
+	std::uint32_t _id;
+	std::string _name;
+	std::string _location;
+	std::uint32_t _fan_count;
+	TelemetryStore _telemetry;
+	TelemetryHistory _history;
+	SingleFlight<std::uint16_t> _pump_rpm_read;
+	SingleFlight<std::vector<std::uint16_t>> _fans_rpm_read;
+	SingleFlight<FixedPoint<16>> _temperature_read;
+	SingleFlight<SensorSnapshot> _snapshot_read;
+	SingleFlight<void> _sensors_read;
+	SensorSampler _sampler;
+
+	mutable std::mutex _mutex;
+	DeviceSettings _settings;
+	DeviceSettings _applied;
+	WriteChannel _pump_writes;
+	WriteChannel _fans_writes;
+	std::shared_ptr<DeviceWorker> _worker;
+	std::shared_ptr<BufferPool> _buffer_pool;
+};
+
+} // namespace ccool
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace ccool {
+
+/**
+ * Unbounded lock-free queue with multiple producers and single consumer.
+ * Producers only ever perform single atomic exchange so they never wait for
+ * each other or for the consumer. Only one thread at a time may call `pop()`.
+ */
+template <typename T>
+class MpscQueue
+{
+	struct Node
+	{
+		std::atomic<Node*> next;
+		std::optional<T> value;
+	};
+
+public:
+	MpscQueue() : _head(new Node{nullptr, std::nullopt}), _tail(_head.load()) {}
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue(MpscQueue&&) noexcept = delete;
+
+	~MpscQueue()
+	{
+		while (pop())
+			;
+		delete _tail;
+	}
+
+	MpscQueue& operator=(const MpscQueue&) = delete;
+	MpscQueue& operator=(MpscQueue&&) noexcept = delete;
+
+	void push(T value)
+	{
+		auto* node = new Node{nullptr, std::move(value)};
+		auto* prev = _head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	/**
+	 * Returns std::nullopt if the queue is empty or if the next element is still being
+	 * pushed by some producer. In the latter case, it becomes available almost immediately.
+	 */
+	std::optional<T> pop()
+	{
+		auto* tail = _tail;
+		auto* next = tail->next.load(std::memory_order_acquire);
+		if (!next)
+			return std::nullopt;
+
+		// Node that we pop from becomes new stub node
+		_tail = next;
+		auto result = std::move(next->value);
+		next->value.reset();
+		delete tail;
+		return result;
+	}
+
+private:
+	std::atomic<Node*> _head;
+	Node* _tail;
+};
+
+} // namespace ccool
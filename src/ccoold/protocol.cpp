@@ -0,0 +1,83 @@
+#include "protocol.hpp"
+
+namespace ccool {
+
+AsyncExchange::AsyncExchange(
+	DeviceInterface* device_interface,
+	std::uint8_t endpoint,
+	std::span<const ControlRequest> pre_request,
+	const Buffer& request,
+	std::span<const ControlRequest> post_response,
+	TransferCallback&& callback
+) : _device_interface(device_interface), _endpoint(endpoint), _pre_request(pre_request),
+	_request(device_interface->get_buffer_pool()->acquire(request.get_data())),
+	_post_response(post_response), _callback(std::move(callback)), _step(0), _response()
+{
+}
+
+void AsyncExchange::start(
+	DeviceInterface* device_interface,
+	std::uint8_t endpoint,
+	std::span<const ControlRequest> pre_request,
+	const Buffer& request,
+	std::span<const ControlRequest> post_response,
+	TransferCallback callback
+)
+{
+	auto exchange = std::make_shared<AsyncExchange>(device_interface, endpoint, pre_request, request, post_response, std::move(callback));
+	exchange->next_step();
+}
+
+void AsyncExchange::next_step()
+{
+	// Steps go in the following order:
+	//   [0, pre_request)         - control requests before the request
+	//   pre_request              - sending the request
+	//   pre_request + 1          - receiving the response
+	//   [pre_request + 2, end)   - control requests after the response
+	auto done = [self = shared_from_this()](std::exception_ptr error, Buffer data) {
+		self->on_step_done(error, std::move(data));
+	};
+
+	auto send_step = _pre_request.size();
+	auto recv_step = send_step + 1;
+	auto post_response_step = recv_step + 1;
+
+	if (_step < send_step)
+	{
+		const auto& control = _pre_request[_step];
+		_device_interface->control_async(control.request_type, control.request, control.value, std::move(done));
+	}
+	else if (_step == send_step)
+		_device_interface->send_async(_endpoint, _request, std::move(done));
+	else if (_step == recv_step)
+		_device_interface->recv_async(_endpoint, std::move(done));
+	else if (_step < post_response_step + _post_response.size())
+	{
+		const auto& control = _post_response[_step - post_response_step];
+		_device_interface->control_async(control.request_type, control.request, control.value, std::move(done));
+	}
+	else
+	{
+		auto callback = std::move(_callback);
+		callback(nullptr, std::move(_response));
+	}
+}
+
+void AsyncExchange::on_step_done(std::exception_ptr error, Buffer data)
+{
+	if (error)
+	{
+		auto callback = std::move(_callback);
+		callback(error, Buffer{});
+		return;
+	}
+
+	if (_step == _pre_request.size() + 1)
+		_response = std::move(data);
+
+	++_step;
+	next_step();
+}
+
+} // namespace ccool
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <concepts>
+#include <future>
+#include <memory>
+#include <span>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include "buffer.hpp"
 #include "interfaces/device_interface.hpp"
@@ -9,48 +14,195 @@
 
 namespace ccool {
 
-template <Endian DataEndian, typename OpcodeTypeT>
+struct ControlRequest
+{
+	std::uint32_t request_type;
+	std::uint32_t request;
+	std::uint32_t value;
+};
+
+/**
+ * Single request-response exchange with the device performed using asynchronous
+ * transfers. Control requests which precede the request and follow the response
+ * are chained together with the bulk transfers so the caller is never blocked.
+ */
+class AsyncExchange : public std::enable_shared_from_this<AsyncExchange>
+{
+public:
+	static void start(
+		DeviceInterface* device_interface,
+		std::uint8_t endpoint,
+		std::span<const ControlRequest> pre_request,
+		const Buffer& request,
+		std::span<const ControlRequest> post_response,
+		TransferCallback callback
+	);
+
+	AsyncExchange(
+		DeviceInterface* device_interface,
+		std::uint8_t endpoint,
+		std::span<const ControlRequest> pre_request,
+		const Buffer& request,
+		std::span<const ControlRequest> post_response,
+		TransferCallback&& callback
+	);
+
+private:
+	void next_step();
+	void on_step_done(std::exception_ptr error, Buffer data);
+
+	DeviceInterface* _device_interface;
+	std::uint8_t _endpoint;
+	std::span<const ControlRequest> _pre_request;
+	Buffer _request;
+	std::span<const ControlRequest> _post_response;
+	TransferCallback _callback;
+	std::size_t _step;
+	Buffer _response;
+};
+
+/**
+ * Common part of all generated protocols. `Derived` is the generated protocol class which
+ * provides `PreRequest`, `PostResponse` and `SupportsSessions` constants and the messages
+ * themselves. Everything is resolved statically so `Device` calls into the concrete protocol
+ * without any virtual dispatch.
+ */
+template <typename Derived, Endian DataEndian, typename OpcodeTypeT>
 class Protocol
 {
 public:
 	static constexpr Endian endian = DataEndian;
 	using OpcodeType = OpcodeTypeT;
 
-	Protocol(DeviceInterface* device_interface, const std::string& name) : _device_interface(device_interface), _name(name) {}
-	virtual ~Protocol() = default;
+	Protocol(DeviceInterface* device_interface, const std::string& name) : _device_interface(device_interface), _session_depth(0), _name(name) {}
 
 	const std::string& get_name() const { return _name; }
+	bool in_session() const { return _session_depth > 0; }
 
 	Buffer send(std::uint8_t endpoint, const Buffer& data)
 	{
-		pre_request();
-		_device_interface->send(endpoint, data);
-		auto response = _device_interface->recv(endpoint);
-		post_response();
-		return response;
+		auto result = send_async(endpoint, data);
+		_device_interface->wait_for(result);
+		return result.get();
+	}
+
+	std::future<Buffer> send_async(std::uint8_t endpoint, const Buffer& data)
+	{
+		auto promise = std::make_shared<std::promise<Buffer>>();
+		auto result = promise->get_future();
+
+		send_async(endpoint, data, [promise](std::exception_ptr error, Buffer response) {
+			if (error)
+				promise->set_exception(error);
+			else
+				promise->set_value(std::move(response));
+		});
+
+		return result;
+	}
+
+	void send_async(std::uint8_t endpoint, const Buffer& data, TransferCallback callback)
+	{
+		// Control requests are already performed by the session itself
+		if (in_session())
+			AsyncExchange::start(_device_interface, endpoint, {}, data, {}, std::move(callback));
+		else
+			AsyncExchange::start(_device_interface, endpoint, get_pre_request(), data, get_post_response(), std::move(callback));
+	}
+
+	/**
+	 * Starts session in which multiple messages share single pre-request and post-response
+	 * sequence of control requests. Sessions can be nested and only the outermost one
+	 * performs the control requests. If the protocol does not allow sessions, each message
+	 * is still sent with its own control requests. Prefer using `Session` instead of calling
+	 * this directly.
+	 */
+	void begin_session()
+	{
+		if (!supports_sessions())
+			return;
+
+		if (_session_depth++ == 0)
+		{
+			try
+			{
+				pre_request();
+			}
+			catch (...)
+			{
+				_session_depth = 0;
+				throw;
+			}
+		}
 	}
 
-	virtual void pre_request() {}
-	virtual void post_response() {}
-
-	virtual std::uint16_t read_pump_rpm(std::uint8_t endpoint) = 0;
-	virtual std::tuple<std::uint32_t, std::uint16_t> read_fan_rpm(std::uint8_t endpoint, std::uint8_t fan_index) = 0;
-	virtual FixedPoint<16> read_temperature(std::uint8_t endpoint) = 0;
-	virtual std::tuple<std::uint8_t, std::uint8_t, std::uint8_t> read_firmware_version(std::uint8_t endpoint) = 0;
-	virtual void write_pump_mode(std::uint8_t endpoint, std::uint8_t mode) = 0;
-	virtual void write_fan_curve(std::uint8_t endpoint, std::uint8_t fan_index, const std::vector<std::uint8_t>& temperatures, const std::vector<std::uint8_t>& pwm) = 0;
-	virtual void write_fan_pwm(std::uint8_t endpoint, std::uint8_t fan_index, std::uint8_t pwm) = 0;
-	virtual void write_fan_rpm(std::uint8_t endpoint, std::uint8_t fan_index, std::uint16_t rpm) = 0;
-	virtual void write_custom_led_color_enabled(std::uint8_t endpoint, std::uint8_t enabled) = 0;
-	virtual void write_custom_led_color(std::uint8_t endpoint, std::uint8_t red, std::uint8_t green, std::uint8_t blue) = 0;
-	virtual void write_enabled_external_temperature(std::uint8_t endpoint, std::uint8_t enabled) = 0;
-	virtual void write_external_temperature(std::uint8_t endpoint, const FixedPoint<16>& temperature) = 0;
+	void end_session()
+	{
+		if (!supports_sessions() || _session_depth == 0)
+			return;
+
+		if (--_session_depth == 0)
+			post_response();
+	}
+
+	void pre_request()
+	{
+		for (const auto& control : get_pre_request())
+			_device_interface->control(control.request_type, control.request, control.value);
+	}
+
+	void post_response()
+	{
+		for (const auto& control : get_post_response())
+			_device_interface->control(control.request_type, control.request, control.value);
+	}
+
+	static constexpr std::span<const ControlRequest> get_pre_request() { return Derived::PreRequest; }
+	static constexpr std::span<const ControlRequest> get_post_response() { return Derived::PostResponse; }
+	static constexpr bool supports_sessions() { return Derived::SupportsSessions; }
 
 protected:
+	// Never destroyed through pointer to the base, protocols are held by value
+	~Protocol() = default;
+
 	DeviceInterface* _device_interface;
 
 private:
+	std::size_t _session_depth;
 	std::string _name;
 };
 
+/**
+ * Messages every protocol has to provide so it can be driven by `Device`.
+ */
+template <typename T>
+concept DeviceProtocol = requires(
+	T protocol,
+	std::uint8_t endpoint,
+	std::uint8_t value,
+	std::uint16_t rpm,
+	std::span<const std::uint8_t> values,
+	const FixedPoint<16>& temperature,
+	typename T::WriteFanCurveLayout::RequestImageType& curve_request
+)
+{
+	protocol.begin_session();
+	protocol.end_session();
+	{ protocol.read_pump_rpm(endpoint) } -> std::same_as<std::uint16_t>;
+	{ protocol.read_fan_rpm(endpoint, value) } -> std::same_as<std::tuple<std::uint32_t, std::uint16_t>>;
+	{ protocol.read_temperature(endpoint) } -> std::same_as<FixedPoint<16>>;
+	{ protocol.read_firmware_version(endpoint) } -> std::same_as<std::tuple<std::uint8_t, std::uint8_t, std::uint8_t>>;
+	protocol.write_pump_mode(endpoint, value);
+	protocol.write_fan_curve(endpoint, value, values, values);
+	{ T::WriteFanCurveLayout::encode(value, values, values) } -> std::same_as<typename T::WriteFanCurveLayout::RequestImageType>;
+	T::WriteFanCurveLayout::set_fan_index(curve_request, value);
+	protocol.write_fan_curve(endpoint, curve_request);
+	protocol.write_fan_pwm(endpoint, value, value);
+	protocol.write_fan_rpm(endpoint, value, rpm);
+	protocol.write_custom_led_color_enabled(endpoint, value);
+	protocol.write_custom_led_color(endpoint, value, value, value);
+	protocol.write_enabled_external_temperature(endpoint, value);
+	protocol.write_external_temperature(endpoint, temperature);
+};
+
 } // namespace ccool
@@ -0,0 +1,58 @@
+#include <spdlog/spdlog.h>
+
+#include "logging.hpp"
+#include "sensor_sampler.hpp"
+
+namespace ccool {
+
+SensorSampler::SensorSampler(ReadSensors read_sensors, std::chrono::milliseconds interval)
+	: _read_sensors(std::move(read_sensors)), _interval(interval), _next_sample_time(Clock::now()), _pending_sample()
+{
+}
+
+SensorSampler::~SensorSampler()
+{
+	if (_pending_sample.valid())
+		_pending_sample.wait();
+}
+
+Clock::time_point SensorSampler::poll()
+{
+	if (!is_enabled())
+		return Clock::time_point::max();
+
+	auto now = Clock::now();
+	if (now < _next_sample_time)
+		return _next_sample_time;
+
+	sample();
+
+	// Don't try to catch up with missed samples if sampling took too long
+	_next_sample_time += _interval;
+	if (_next_sample_time < now)
+		_next_sample_time = now + _interval;
+
+	return _next_sample_time;
+}
+
+void SensorSampler::sample()
+{
+	using namespace std::literals;
+
+	if (_pending_sample.valid() && _pending_sample.wait_for(0s) != std::future_status::ready)
+	{
+		LOG->debug("Previous sample still in progress, skipping");
+		return;
+	}
+
+	try
+	{
+		_pending_sample = _read_sensors();
+	}
+	catch (const std::exception& error)
+	{
+		LOG->warn("Failed to sample sensors: {}", error.what());
+	}
+}
+
+} // namespace ccool
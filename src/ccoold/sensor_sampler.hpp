@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <future>
+
+#include "telemetry.hpp"
+
+namespace ccool {
+
+/**
+ * Periodically reads all sensors of the device into the telemetry store so
+ * readers can be served without touching the device. Sampling is disabled
+ * if the interval is zero.
+ */
+class SensorSampler
+{
+public:
+	using ReadSensors = std::function<std::shared_future<void>()>;
+
+	SensorSampler(ReadSensors read_sensors, std::chrono::milliseconds interval);
+	~SensorSampler();
+
+	std::chrono::milliseconds get_interval() const { return _interval; }
+	bool is_enabled() const { return _interval.count() > 0; }
+
+	/**
+	 * Submits reading of all sensors if the next sample is due. Returns time point of the next sample.
+	 */
+	Clock::time_point poll();
+
+	/**
+	 * Submits reading of all sensors without waiting for it.
+	 * Sample is skipped if the previous one is still in progress.
+	 */
+	void sample();
+
+private:
+	ReadSensors _read_sensors;
+	std::chrono::milliseconds _interval;
+	Clock::time_point _next_sample_time;
+	std::shared_future<void> _pending_sample;
+};
+
+} // namespace ccool
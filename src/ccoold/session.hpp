@@ -0,0 +1,48 @@
+#pragma once
+
+#include <utility>
+
+namespace ccool {
+
+/**
+ * Scoped session over anything providing `begin_session()` and `end_session()`
+ * (protocols and devices). Session is ended when leaving the scope or explicitly
+ * by calling `close()` which, unlike the destructor, propagates errors.
+ */
+template <typename T>
+class Session
+{
+public:
+	Session(T& owner) : _owner(&owner)
+	{
+		_owner->begin_session();
+	}
+
+	Session(const Session&) = delete;
+	Session(Session&& rhs) noexcept : _owner(std::exchange(rhs._owner, nullptr)) {}
+
+	~Session()
+	{
+		try
+		{
+			close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	Session& operator=(const Session&) = delete;
+	Session& operator=(Session&&) noexcept = delete;
+
+	void close()
+	{
+		if (auto* owner = std::exchange(_owner, nullptr); owner)
+			owner->end_session();
+	}
+
+private:
+	T* _owner;
+};
+
+} // namespace ccool
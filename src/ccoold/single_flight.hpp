@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <mutex>
+
+namespace ccool {
+
+/**
+ * Deduplicates concurrent executions of the same operation. While the operation
+ * is in flight, everyone who asks for it gets the result of the pending one instead
+ * of starting it again. Once it finishes, next call starts it anew.
+ */
+template <typename T>
+class SingleFlight
+{
+public:
+	SingleFlight() : _mutex(), _pending() {}
+	SingleFlight(const SingleFlight&) = delete;
+	SingleFlight(SingleFlight&&) noexcept = delete;
+
+	SingleFlight& operator=(const SingleFlight&) = delete;
+	SingleFlight& operator=(SingleFlight&&) noexcept = delete;
+
+	/**
+	 * Returns result of the pending operation or starts a new one using `start`
+	 * which needs to return `std::future<T>`.
+	 */
+	template <typename Fn>
+	std::shared_future<T> run(Fn&& start)
+	{
+		using namespace std::literals;
+
+		std::lock_guard lock(_mutex);
+		if (!_pending.valid() || _pending.wait_for(0s) == std::future_status::ready)
+			_pending = start().share();
+
+		return _pending;
+	}
+
+private:
+	std::mutex _mutex;
+	std::shared_future<T> _pending;
+};
+
+} // namespace ccool
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "fixed_point.hpp"
+
+namespace ccool {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Last known value of a single sensor together with the time it was read.
+ */
+template <typename T>
+class CachedValue
+{
+public:
+	CachedValue() : _mutex(), _value(), _timestamp() {}
+
+	void update(const T& value, Clock::time_point timestamp = Clock::now())
+	{
+		std::lock_guard lock(_mutex);
+		_value = value;
+		_timestamp = timestamp;
+	}
+
+	std::optional<T> get(std::chrono::milliseconds max_age = std::chrono::milliseconds::max()) const
+	{
+		// Age is rounded up so even sub-millisecond old values are too old for zero `max_age`.
+		// Comparing it in nanoseconds would overflow for `max_age` close to the maximum.
+		std::lock_guard lock(_mutex);
+		if (!_value || std::chrono::ceil<std::chrono::milliseconds>(Clock::now() - _timestamp) > max_age)
+			return std::nullopt;
+
+		return _value;
+	}
+
+	void reset()
+	{
+		std::lock_guard lock(_mutex);
+		_value.reset();
+	}
+
+	/**
+	 * Returns cached value if it is not older than `max_age`. Otherwise obtains fresh
+	 * value using `read` and stores it.
+	 */
+	template <typename Fn>
+	T get_or_update(std::chrono::milliseconds max_age, Fn&& read)
+	{
+		if (auto value = get(max_age); value)
+			return std::move(value).value();
+
+		auto value = read();
+		update(value);
+		return value;
+	}
+
+private:
+	mutable std::mutex _mutex;
+	std::optional<T> _value;
+	Clock::time_point _timestamp;
+};
+
+struct TelemetryStore
+{
+	CachedValue<std::uint16_t> pump_rpm;
+	CachedValue<std::vector<std::uint16_t>> fans_rpm;
+	CachedValue<FixedPoint<16>> temperature;
+
+	void reset()
+	{
+		pump_rpm.reset();
+		fans_rpm.reset();
+		temperature.reset();
+	}
+};
+
+} // namespace ccool
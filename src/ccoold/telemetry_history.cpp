@@ -0,0 +1,139 @@
+#include <algorithm>
+
+#include <conversion.hpp>
+
+#include "telemetry_history.hpp"
+
+namespace ccool {
+
+namespace {
+
+std::int64_t align(std::int64_t time, std::int64_t step)
+{
+	auto remainder = time % step;
+	return remainder < 0 ? time - remainder - step : time - remainder;
+}
+
+} // namespace
+
+TimeSeries::Tier::Tier(const TierSpec& spec) : _step(spec.step), _buckets(spec.capacity), _head(0), _size(0)
+{
+}
+
+void TimeSeries::Tier::add(double value, std::int64_t time)
+{
+	auto bucket_time = align(time, _step);
+
+	// Values which come out of order (clock adjustments) are merged into the latest bucket
+	if (_size > 0)
+	{
+		auto& last = _buckets[(_head + _buckets.size() - 1) % _buckets.size()];
+		if (bucket_time <= last.time)
+		{
+			last.min = std::min(last.min, static_cast<float>(value));
+			last.max = std::max(last.max, static_cast<float>(value));
+			last.sum += value;
+			++last.count;
+			return;
+		}
+	}
+
+	_buckets[_head] = Bucket{bucket_time, static_cast<float>(value), static_cast<float>(value), value, 1};
+	_head = (_head + 1) % _buckets.size();
+	_size = std::min(_size + 1, _buckets.size());
+}
+
+TimeSeries::TimeSeries() : _mutex(), _tiers(std::begin(Tiers), std::end(Tiers))
+{
+}
+
+void TimeSeries::add(double value, SystemClock::time_point time)
+{
+	auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+
+	std::lock_guard lock(_mutex);
+	for (auto& tier : _tiers)
+		tier.add(value, seconds);
+}
+
+std::optional<std::vector<HistoryPoint>> TimeSeries::query(std::int64_t from, std::int64_t step) const
+{
+	if (step <= 0)
+		return std::nullopt;
+
+	auto tier = std::find_if(_tiers.rbegin(), _tiers.rend(), [step](const auto& tier) {
+		return step % tier.get_step() == 0;
+	});
+	if (tier == _tiers.rend())
+		return std::nullopt;
+
+	std::vector<HistoryPoint> result;
+	std::uint32_t count = 0;
+	double sum = 0.0;
+
+	std::lock_guard lock(_mutex);
+	tier->for_each([&](const Bucket& bucket) {
+		if (bucket.time < from)
+			return;
+
+		auto point_time = align(bucket.time, step);
+		if (result.empty() || result.back().time != point_time)
+		{
+			if (!result.empty())
+				result.back().avg = sum / count;
+
+			result.push_back(HistoryPoint{point_time, bucket.min, bucket.max, 0.0});
+			count = 0;
+			sum = 0.0;
+		}
+
+		auto& point = result.back();
+		point.min = std::min(point.min, static_cast<double>(bucket.min));
+		point.max = std::max(point.max, static_cast<double>(bucket.max));
+		sum += bucket.sum;
+		count += bucket.count;
+	});
+
+	if (!result.empty())
+		result.back().avg = sum / count;
+
+	return result;
+}
+
+TelemetryHistory::TelemetryHistory(std::uint32_t fan_count) : _pump_rpm(), _fans_rpm(fan_count), _temperature()
+{
+}
+
+void TelemetryHistory::record_pump_rpm(std::uint16_t rpm, SystemClock::time_point time)
+{
+	_pump_rpm.add(rpm, time);
+}
+
+void TelemetryHistory::record_fans_rpm(const std::vector<std::uint16_t>& rpms, SystemClock::time_point time)
+{
+	for (std::size_t i = 0; i < std::min(rpms.size(), _fans_rpm.size()); ++i)
+		_fans_rpm[i].add(rpms[i], time);
+}
+
+void TelemetryHistory::record_temperature(const FixedPoint<16>& temperature, SystemClock::time_point time)
+{
+	_temperature.add(temperature.floating(), time);
+}
+
+const TimeSeries* TelemetryHistory::get_series(const std::string& sensor) const
+{
+	if (sensor == "pump")
+		return &_pump_rpm;
+	else if (sensor == "temperature")
+		return &_temperature;
+	else if (sensor.starts_with("fan"))
+	{
+		auto index = convert<std::uint32_t>(sensor.substr(3));
+		if (index && index.value() < _fans_rpm.size())
+			return &_fans_rpm[index.value()];
+	}
+
+	return nullptr;
+}
+
+} // namespace ccool
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "fixed_point.hpp"
+
+namespace ccool {
+
+using SystemClock = std::chrono::system_clock;
+
+/**
+ * Aggregate of all values of a sensor within a single time step.
+ */
+struct HistoryPoint
+{
+	std::int64_t time; ///< Start of the step in seconds since epoch
+	double min;
+	double max;
+	double avg;
+};
+
+/**
+ * History of a single sensor kept in fixed amount of memory. Each value is aggregated into
+ * multiple tiers of increasing step (1 second, 1 minute, 1 hour) where each tier is a ring
+ * buffer of a fixed size, so the finer tiers cover recent history while the coarser ones
+ * reach further to the past.
+ */
+class TimeSeries
+{
+public:
+	struct TierSpec
+	{
+		std::int64_t step;
+		std::size_t capacity;
+	};
+
+	static constexpr TierSpec Tiers[] = {
+		{1, 15 * 60},   // 15 minutes
+		{60, 24 * 60},  // 1 day
+		{3600, 30 * 24} // 30 days
+	};
+
+	TimeSeries();
+
+	void add(double value, SystemClock::time_point time = SystemClock::now());
+
+	/**
+	 * Returns all points starting at or after `from` (seconds since epoch) aggregated
+	 * into steps of `step` seconds. Data are taken from the coarsest tier whose step
+	 * divides `step`. Returns std::nullopt if there is no such tier.
+	 */
+	std::optional<std::vector<HistoryPoint>> query(std::int64_t from, std::int64_t step) const;
+
+private:
+	struct Bucket
+	{
+		std::int64_t time;
+		float min;
+		float max;
+		double sum;
+		std::uint32_t count;
+	};
+
+	class Tier
+	{
+	public:
+		Tier(const TierSpec& spec);
+
+		std::int64_t get_step() const { return _step; }
+
+		void add(double value, std::int64_t time);
+
+		template <typename Fn>
+		void for_each(Fn&& fn) const
+		{
+			for (std::size_t i = 0; i < _size; ++i)
+				fn(_buckets[(_head + _buckets.size() - _size + i) % _buckets.size()]);
+		}
+
+	private:
+		std::int64_t _step;
+		std::vector<Bucket> _buckets;
+		std::size_t _head;
+		std::size_t _size;
+	};
+
+	mutable std::mutex _mutex;
+	std::vector<Tier> _tiers;
+};
+
+/**
+ * History of all sensors of a single device.
+ */
+class TelemetryHistory
+{
+public:
+	TelemetryHistory(std::uint32_t fan_count);
+
+	void record_pump_rpm(std::uint16_t rpm, SystemClock::time_point time = SystemClock::now());
+	void record_fans_rpm(const std::vector<std::uint16_t>& rpms, SystemClock::time_point time = SystemClock::now());
+	void record_temperature(const FixedPoint<16>& temperature, SystemClock::time_point time = SystemClock::now());
+
+	/**
+	 * Returns history of sensor named `pump`, `fan<index>` or `temperature`.
+	 * Returns nullptr if there is no such sensor.
+	 */
+	const TimeSeries* get_series(const std::string& sensor) const;
+
+private:
+	TimeSeries _pump_rpm;
+	std::vector<TimeSeries> _fans_rpm;
+	TimeSeries _temperature;
+};
+
+} // namespace ccool
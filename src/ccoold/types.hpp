@@ -1,6 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <span>
+
+#include "fixed_point.hpp"
 
 namespace ccool {
 
@@ -29,4 +33,20 @@ struct Version
 	std::uint8_t major, minor, patch;
 };
 
+/**
+ * Readings of all sensors of the device taken at once. Fans are stored inline so taking
+ * the snapshot does not allocate, only first `fan_count` of them are valid.
+ */
+struct SensorSnapshot
+{
+	static constexpr std::size_t MaxFans = 8;
+
+	std::uint16_t pump_rpm = 0;
+	std::uint32_t fan_count = 0;
+	std::array<std::uint16_t, MaxFans> fans_rpm = {};
+	FixedPoint<16> temperature = {};
+
+	std::span<const std::uint16_t> get_fans_rpm() const { return {fans_rpm.data(), fan_count}; }
+};
+
 } // namespace ccool
@@ -0,0 +1,62 @@
+#include "worker_pool.hpp"
+
+namespace ccool {
+
+WorkerPool::WorkerPool(std::size_t thread_count) : _mutex(), _tasks(), _pending(0), _threads()
+{
+	_threads.reserve(thread_count);
+	for (std::size_t i = 0; i < thread_count; ++i)
+	{
+		_threads.emplace_back([this]() {
+			run();
+		});
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	// Empty task tells a thread to stop. They are queued after all the submitted tasks so those are still finished.
+	for (std::size_t i = 0; i < _threads.size(); ++i)
+		push(Task{});
+
+	for (auto& thread : _threads)
+		thread.join();
+}
+
+void WorkerPool::submit(Task&& task)
+{
+	if (task)
+		push(std::move(task));
+}
+
+void WorkerPool::push(Task&& task)
+{
+	{
+		std::lock_guard lock(_mutex);
+		_tasks.push_back(std::move(task));
+	}
+
+	_pending.release();
+}
+
+void WorkerPool::run()
+{
+	while (true)
+	{
+		_pending.acquire();
+
+		Task task;
+		{
+			std::lock_guard lock(_mutex);
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+		}
+
+		if (!task)
+			break;
+
+		task();
+	}
+}
+
+} // namespace ccool
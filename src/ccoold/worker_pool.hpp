@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace ccool {
+
+/**
+ * Small pool of threads for work which would otherwise block the event loop.
+ * Tasks are started in the order they were submitted but may run concurrently.
+ * Tasks which were already submitted are still finished when the pool is destroyed.
+ */
+class WorkerPool
+{
+public:
+	using Task = std::function<void()>;
+
+	WorkerPool(std::size_t thread_count);
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool(WorkerPool&&) noexcept = delete;
+	~WorkerPool();
+
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	WorkerPool& operator=(WorkerPool&&) noexcept = delete;
+
+	void submit(Task&& task);
+
+private:
+	void push(Task&& task);
+	void run();
+
+	std::mutex _mutex;
+	std::deque<Task> _tasks;
+	std::counting_semaphore<> _pending;
+	std::vector<std::thread> _threads;
+};
+
+} // namespace ccool
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ccool {
+
+/**
+ * Compact alternative to the HTTP/JSON IPC for clients which poll the daemon often.
+ *
+ * Every message starts with its header followed by fixed-size payload of the operation.
+ * `length` in the header is the size of the whole message including the header. Both ends
+ * always run on the same machine so all values are in its native byte order. Each request
+ * carries `tag` chosen by the client which is echoed in its response. Responses to requests
+ * sent over the same connection do not need to come in the order of the requests.
+ */
+enum class IpcOperation : std::uint16_t
+{
+	ReadStatus = 1,
+	ReadPump,
+	ReadFans,
+	ReadTemperature,
+	ReadFirmware,
+	WritePumpMode,
+	WriteFansPwm,
+	WriteFansRpm,
+	WriteFansCurve
+};
+
+enum class IpcStatus : std::uint16_t
+{
+	Ok = 0,
+	InvalidRequest,
+	UnknownOperation,
+	DeviceNotFound,
+	DeviceDetached,
+	Failed
+};
+
+// Reads with this maximum age use the default of the daemon like HTTP requests without `max_age`
+constexpr std::uint32_t IpcDefaultMaxAge = std::numeric_limits<std::uint32_t>::max();
+constexpr std::size_t IpcMaxFans = 8;
+constexpr std::size_t IpcMaxCurvePoints = 16;
+constexpr std::size_t IpcMaxMessageSize = 256;
+
+struct IpcRequestHeader
+{
+	std::uint32_t length;
+	std::uint32_t tag;
+	IpcOperation operation;
+	std::uint16_t device_id;
+};
+
+struct IpcResponseHeader
+{
+	std::uint32_t length;
+	std::uint32_t tag;
+	IpcOperation operation;
+	IpcStatus status;
+};
+
+// Request of ReadStatus, ReadPump, ReadFans and ReadTemperature. ReadFirmware has no payload.
+struct IpcReadRequest
+{
+	std::uint32_t max_age;
+};
+
+struct IpcWritePumpModeRequest
+{
+	std::uint8_t mode;
+};
+
+struct IpcWriteFansPwmRequest
+{
+	std::uint8_t pwm;
+};
+
+struct IpcWriteFansRpmRequest
+{
+	std::uint16_t rpm;
+};
+
+struct IpcWriteFansCurveRequest
+{
+	std::uint8_t size;
+	std::array<std::uint8_t, IpcMaxCurvePoints> temperatures;
+	std::array<std::uint8_t, IpcMaxCurvePoints> pwms;
+};
+
+// Temperatures are in thousandths of degree Celsius
+struct IpcStatusResponse
+{
+	std::uint16_t pump_rpm;
+	std::uint16_t fan_count;
+	std::array<std::uint16_t, IpcMaxFans> fans_rpm;
+	std::int32_t temperature;
+};
+
+struct IpcPumpResponse
+{
+	std::uint16_t rpm;
+};
+
+struct IpcFansResponse
+{
+	std::uint16_t fan_count;
+	std::array<std::uint16_t, IpcMaxFans> rpm;
+};
+
+struct IpcTemperatureResponse
+{
+	std::int32_t temperature;
+};
+
+struct IpcFirmwareResponse
+{
+	std::uint8_t major;
+	std::uint8_t minor;
+	std::uint8_t patch;
+};
+
+// Write operations have no payload in their responses
+struct IpcEmptyPayload
+{
+};
+
+/**
+ * Returns the message consisting of `header` and `payload` with the length set.
+ */
+template <typename Header, typename Payload = IpcEmptyPayload>
+std::string encode_ipc_message(Header header, const Payload& payload = {})
+{
+	static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Payload>);
+
+	constexpr auto payload_size = std::is_empty_v<Payload> ? 0 : sizeof(Payload);
+	static_assert(sizeof(Header) + payload_size <= IpcMaxMessageSize);
+
+	header.length = static_cast<std::uint32_t>(sizeof(Header) + payload_size);
+	std::string result(header.length, '\0');
+	std::memcpy(result.data(), &header, sizeof(Header));
+	if constexpr (payload_size > 0)
+		std::memcpy(result.data() + sizeof(Header), &payload, payload_size);
+	return result;
+}
+
+/**
+ * Reads the fixed-size header or payload. Returns std::nullopt if `data` is not of its size.
+ */
+template <typename T>
+std::optional<T> decode_ipc(std::string_view data)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	constexpr auto size = std::is_empty_v<T> ? 0 : sizeof(T);
+	if (data.size() != size)
+		return std::nullopt;
+
+	T result{};
+	if constexpr (size > 0)
+		std::memcpy(&result, data.data(), size);
+	return result;
+}
+
+} // namespace ccool
@@ -33,7 +33,7 @@ std::optional<T> sequence_to(const char* data, std::size_t length)
 {
 	T result = {};
 	auto [ptr, error_code] = std::from_chars(data, data + length, result);
-	if (error_code == std::errc{} && (!ptr || ptr != data + length))
+	if (error_code != std::errc{} || ptr != data + length)
 		return std::nullopt;
 	return result;
 }
@@ -40,6 +40,7 @@ class FakedevChannel:
     def __init__(self, socket_path: str, device_spec: dict):
         self.socket_path = socket_path
         self.spec = device_spec
+        self.process = None
         self.message_channel = multiprocessing.Queue()
         self._collector_running = False
         self._collector_thread = None
@@ -58,6 +59,14 @@ class FakedevChannel:
         if self._collector_thread is not None:
             self._collector_thread.join()
 
+    def detach(self):
+        """
+        Emulates unplugging of the device. Daemon notices that its socket disappeared.
+        """
+        self.process.terminate()
+        self.process.join()
+        os.unlink(self.socket_path)
+
     def ping(self):
         try:
             status = self._send_request("/")
@@ -114,8 +123,9 @@ class FakedevChannel:
 
 
 class CCool:
-    def __init__(self, socket_path: str):
+    def __init__(self, socket_path: str, binary_socket_path: str):
         self.socket_path = socket_path
+        self.binary_socket_path = binary_socket_path
 
     def ping(self):
         try:
@@ -123,14 +133,15 @@ class CCool:
         except Exception:
             return False
 
-    def run(self, *args):
+    def run(self, *args, binary=False):
         stdout = None
         stderr = None
         process = None
 
         try:
+            binary_args = ["--binary-socket", self.binary_socket_path] if binary else []
             process = subprocess.Popen(
-                ["ccool", "--json", "--socket", self.socket_path, *list([str(arg) for arg in args])],
+                ["ccool", "--json", "--socket", self.socket_path, *binary_args, *list([str(arg) for arg in args])],
                 stdout=subprocess.PIPE,
                 stderr=subprocess.PIPE,
                 text=True
@@ -165,6 +176,10 @@ def get_ccoold_socket_path():
     return os.path.realpath(f"ccoold.{get_normalized_test_name()}.sock")
 
 
+def get_ccoold_binary_socket_path():
+    return os.path.realpath(f"ccoold.{get_normalized_test_name()}.bin.sock")
+
+
 def get_fakedev_socket_path():
     return os.path.realpath(f"fakedev.{get_normalized_test_name()}.sock")
 
@@ -178,7 +193,7 @@ def fakedev(request):
     if os.path.exists(socket_path):
         os.unlink(socket_path)
     fakedev_channel = FakedevChannel(socket_path, request.param)
-    fakedev_process = multiprocessing.Process(
+    fakedev_channel.process = multiprocessing.Process(
         target=start_fakedev_app,
         args=(socket_path, request.param["usb"]["vendor_id"], request.param["usb"]["product_id"], request.param["protocol"]),
         kwargs={
@@ -188,7 +203,7 @@ def fakedev(request):
 
     try:
         fakedev_channel.start()
-        fakedev_process.start()
+        fakedev_channel.process.start()
 
         tries = 0
         while not fakedev_channel.ping():
@@ -199,24 +214,29 @@ def fakedev(request):
 
         yield fakedev_channel
     finally:
-        fakedev_process.terminate()
-        fakedev_process.join()
+        fakedev_channel.process.terminate()
+        fakedev_channel.process.join()
         fakedev_channel.stop()
-        os.unlink(socket_path)
+        if os.path.exists(socket_path):
+            os.unlink(socket_path)
 
 
 @pytest.fixture
-def ccool():
+def ccool(request):
     socket_path = get_ccoold_socket_path()
+    binary_socket_path = get_ccoold_binary_socket_path()
     fakedev_socket_path = get_fakedev_socket_path()
     ccoold_process = None
 
     try:
         ccoold_env = os.environ.copy()
         ccoold_env["CCOOLD_DEBUG_DEVICE_INTERFACE_SOCKET"] = fakedev_socket_path
-        ccoold_process = subprocess.Popen(["ccoold", "-i", "debug", "-s", socket_path], env=ccoold_env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        # Sampling is disabled unless the test asks for it so devices receive only messages caused by tests
+        sample_interval_marker = request.node.get_closest_marker("sample_interval")
+        sample_interval = sample_interval_marker.args[0] if sample_interval_marker else 0
+        ccoold_process = subprocess.Popen(["ccoold", "-i", "debug", "-s", socket_path, "--binary-socket", binary_socket_path, "--sample-interval", str(sample_interval)], env=ccoold_env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
 
-        ccool = CCool(socket_path)
+        ccool = CCool(socket_path, binary_socket_path)
 
         tries = 0
         while not ccool.ping():
@@ -248,7 +268,9 @@ def ccool():
             f.write(stderr if stderr else "")
 
 
-def pytest_configure():
+def pytest_configure(config):
+    config.addinivalue_line("markers", "sample_interval(milliseconds): run ccoold with sensor sampling enabled")
+
     devices_dir = CCOOL_ROOT_DIR / "specs" / "devices"
     for root, _, files in os.walk(devices_dir):
         for f in filter(lambda f: f.endswith(".yml") or f.endswith(".yaml"), files):
@@ -0,0 +1,7 @@
+def test_binary_unknown_device(fakedev, ccool):
+    try:
+        ccool.run("--device", 5, "pump", binary=True)
+    except RuntimeError as err:
+        assert "Device not found" in str(err)
+    else:
+        assert False, "Request to unknown device over binary IPC did not fail"
@@ -0,0 +1,19 @@
+import pytest
+import time
+
+
+@pytest.mark.sample_interval(100)
+@pytest.mark.parametrize("binary", [False, True], ids=["http", "binary"])
+def test_read_detached_device(fakedev, ccool, binary):
+    # Sampler fills the cache right after the start so these are served from it
+    assert ccool.run("pump", binary=binary) == {"rpm": 0x1122}, "Read Pump RPM did not receive correct response"
+
+    fakedev.detach()
+    timeout_time = time.monotonic() + 5
+    while ccool.run("info")["attached"] and time.monotonic() < timeout_time:
+        time.sleep(0.1)
+    assert not ccool.run("info")["attached"], "Device was not detached"
+
+    for command in ["pump", "fans", "temp", "status"]:
+        with pytest.raises(RuntimeError, match="(?i)device is detached"):
+            ccool.run(command, binary=binary)
@@ -0,0 +1,29 @@
+import socket
+import time
+
+
+def test_read_responses_larger_than_socket_buffer(fakedev, ccool):
+    request_count = 5000
+    request = b"GET /info HTTP/1.1\r\nHost: localhost\r\n\r\n"
+
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as client:
+        client.connect(ccool.socket_path)
+        buffer_size = client.getsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF)
+
+        # Nothing is read until all requests are sent so the responses pile up way over the socket buffer
+        client.sendall(request * request_count)
+
+        client.settimeout(1)
+        data = b""
+        timeout_time = time.monotonic() + 10
+        while data.count(b"HTTP/1.1 200") < request_count and time.monotonic() < timeout_time:
+            try:
+                chunk = client.recv(65536)
+            except socket.timeout:
+                continue
+            if not chunk:
+                break
+            data += chunk
+
+    assert len(data) > buffer_size, "Responses did not exceed the socket buffer"
+    assert data.count(b"HTTP/1.1 200") == request_count, "Not all responses larger than socket buffer were received"
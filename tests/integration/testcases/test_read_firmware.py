@@ -1,8 +1,11 @@
+import pytest
+
 from framework import Call, Repeats, Sequence
 
 
-def test_read_firmware(fakedev, ccool):
-    assert ccool.run("firmware") == {"version": {"major": 1, "minor": 2, "patch": 3}}, "Read Firmware did not receive correct response"
+@pytest.mark.parametrize("binary", [False, True], ids=["http", "binary"])
+def test_read_firmware(fakedev, ccool, binary):
+    assert ccool.run("firmware", binary=binary) == {"version": {"major": 1, "minor": 2, "patch": 3}}, "Read Firmware did not receive correct response"
 
     fakedev.assert_has_message_pattern(
         Repeats(
@@ -0,0 +1,33 @@
+import pytest
+
+from framework import Call, Repeats, Sequence
+
+
+@pytest.mark.parametrize("binary", [False, True], ids=["http", "binary"])
+def test_read_status(fakedev, ccool, binary):
+    assert ccool.run("status", binary=binary) == {
+        "pump": {"rpm": 0x1122},
+        "fans": {"rpm": [0x1122] * fakedev.spec["fans"]},
+        "temperature": 32.5
+    }, "Read Status did not receive correct response"
+
+    fan_reads = [
+        Sequence(
+            Call("send", endpoint=1, data=f"41{i:02}"),
+            Call("recv", endpoint=1)
+        ) for i in range(fakedev.spec["fans"])
+    ]
+    fakedev.assert_has_message_pattern(
+        Repeats(
+            Sequence(
+                Call("send", endpoint=1, data="31"),
+                Call("recv", endpoint=1),
+                *fan_reads,
+                Call("send", endpoint=1, data="a9"),
+                Call("recv", endpoint=1)
+            ),
+            min=1,
+            max=1
+        ),
+        title="Read Status"
+    )
@@ -0,0 +1,37 @@
+import socket
+import time
+
+
+def read_until_closed(client):
+    client.settimeout(1)
+    data = b""
+    timeout_time = time.monotonic() + 10
+    while time.monotonic() < timeout_time:
+        try:
+            chunk = client.recv(65536)
+        except socket.timeout:
+            continue
+        except ConnectionResetError:
+            break
+        if not chunk:
+            break
+        data += chunk
+    return data
+
+
+def test_too_large_request_headers(fakedev, ccool):
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as client:
+        client.connect(ccool.socket_path)
+        # Headers never end so the daemon has to refuse them before they exhaust its memory
+        client.sendall(b"GET /info HTTP/1.1\r\nX-Padding: " + b"a" * 128 * 1024)
+        assert read_until_closed(client).startswith(b"HTTP/1.1 431"), "Too large request headers were not refused"
+
+    assert ccool.run("info")["attached"], "Daemon does not respond after refusing too large request"
+
+
+def test_too_large_request_content(fakedev, ccool):
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as client:
+        client.connect(ccool.socket_path)
+        content_length = 128 * 1024
+        client.sendall(f"POST /pump HTTP/1.1\r\nContent-Length: {content_length}\r\n\r\n".encode() + b"a" * content_length)
+        assert read_until_closed(client).startswith(b"HTTP/1.1 413"), "Too large request content was not refused"
@@ -0,0 +1,37 @@
+from framework import Call, Repeats, Sequence
+
+
+def test_write_dedup(fakedev, ccool):
+    assert ccool.run("fans", "pwm", 42) == {}, "Write Fan PWM did not receive correct response"
+    assert ccool.run("fans", "pwm", 42) == {}, "Repeated Write Fan PWM did not receive correct response"
+    assert ccool.run("pump", 2) == {}, "Write Pump Mode did not receive correct response"
+    assert ccool.run("pump", 2) == {}, "Repeated Write Pump Mode did not receive correct response"
+
+    for i in range(fakedev.spec["fans"]):
+        fakedev.assert_has_message_pattern(
+            Repeats(
+                Sequence(
+                    Call("send", endpoint=1, data=f"42{i:02x}2a"),
+                    Call("recv", endpoint=1)
+                ),
+                min=1,
+                max=1
+            ),
+            title=f"Write Fan PWM #{i}"
+        )
+
+    fakedev.assert_has_message_pattern(
+        Repeats(
+            Sequence(
+                Call("send", endpoint=1, data="3202"),
+                Call("recv", endpoint=1)
+            ),
+            min=1,
+            max=1
+        ),
+        title="Write Pump Mode"
+    )
+
+    writes = ccool.run("info")["writes"]
+    assert writes["fans"] == {"issued": 1, "suppressed": 1, "merged": 0}, "Repeated Write Fan PWM was not suppressed"
+    assert writes["pump"] == {"issued": 1, "suppressed": 1, "merged": 0}, "Repeated Write Pump Mode was not suppressed"
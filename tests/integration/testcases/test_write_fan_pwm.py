@@ -1,8 +1,11 @@
+import pytest
+
 from framework import Call, Repeats, Sequence
 
 
-def test_write_fan_pwm(fakedev, ccool):
-    assert ccool.run("fans", "pwm", 42) == {}, "Write Fan PWM did not receive correct response"
+@pytest.mark.parametrize("binary", [False, True], ids=["http", "binary"])
+def test_write_fan_pwm(fakedev, ccool, binary):
+    assert ccool.run("fans", "pwm", 42, binary=binary) == {}, "Write Fan PWM did not receive correct response"
 
     for i in range(fakedev.spec["fans"]):
         fakedev.assert_has_message_pattern(
@@ -0,0 +1,44 @@
+#include <string>
+
+#include <catch2/catch.hpp>
+
+#include <binary_ipc.hpp>
+
+using namespace ccool;
+
+TEST_CASE("Binary IPC tests", "utils") {
+	SECTION("message with payload") {
+		auto message = encode_ipc_message(IpcRequestHeader{0, 7, IpcOperation::WriteFansRpm, 2}, IpcWriteFansRpmRequest{1200});
+		REQUIRE(message.size() == sizeof(IpcRequestHeader) + sizeof(IpcWriteFansRpmRequest));
+
+		auto header = decode_ipc<IpcRequestHeader>(std::string_view{message}.substr(0, sizeof(IpcRequestHeader)));
+		REQUIRE(header);
+		CHECK(header->length == message.size());
+		CHECK(header->tag == 7);
+		CHECK(header->operation == IpcOperation::WriteFansRpm);
+		CHECK(header->device_id == 2);
+
+		auto request = decode_ipc<IpcWriteFansRpmRequest>(std::string_view{message}.substr(sizeof(IpcRequestHeader)));
+		REQUIRE(request);
+		CHECK(request->rpm == 1200);
+	}
+
+	SECTION("message without payload") {
+		auto message = encode_ipc_message(IpcResponseHeader{0, 3, IpcOperation::WritePumpMode, IpcStatus::DeviceDetached});
+		REQUIRE(message.size() == sizeof(IpcResponseHeader));
+
+		auto header = decode_ipc<IpcResponseHeader>(message);
+		REQUIRE(header);
+		CHECK(header->length == sizeof(IpcResponseHeader));
+		CHECK(header->status == IpcStatus::DeviceDetached);
+		CHECK(decode_ipc<IpcEmptyPayload>(std::string_view{message}.substr(sizeof(IpcResponseHeader))));
+	}
+
+	SECTION("payload of wrong size") {
+		auto data = std::string(sizeof(IpcReadRequest) + 1, '\0');
+		CHECK(!decode_ipc<IpcReadRequest>(data));
+		CHECK(!decode_ipc<IpcReadRequest>(std::string_view{data}.substr(0, sizeof(IpcReadRequest) - 1)));
+		CHECK(decode_ipc<IpcReadRequest>(std::string_view{data}.substr(0, sizeof(IpcReadRequest))));
+		CHECK(!decode_ipc<IpcEmptyPayload>(data));
+	}
+}
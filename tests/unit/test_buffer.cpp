@@ -104,4 +104,128 @@ TEST_CASE("Buffer tests", "utils") {
 		CHECK(buffer.read<Endian::Big, std::uint16_t>() == 0x1234);
 		CHECK(buffer.read<Endian::Big, std::uint16_t>() == 0x1122);
 	}
+
+	SECTION("small buffer is stored inline") {
+		Buffer buffer(Buffer::InlineCapacity);
+		CHECK(buffer.get_size() == Buffer::InlineCapacity);
+		CHECK(buffer.get_capacity() == Buffer::InlineCapacity);
+		CHECK(buffer.get_raw_data() >= reinterpret_cast<std::uint8_t*>(&buffer));
+		CHECK(buffer.get_raw_data() < reinterpret_cast<std::uint8_t*>(&buffer + 1));
+	}
+
+	SECTION("large buffer") {
+		Buffer buffer;
+		for (std::uint32_t i = 0; i < 100; ++i)
+			buffer.write<Endian::Little, std::uint8_t>(static_cast<std::uint8_t>(i));
+
+		REQUIRE(buffer.get_size() == 100);
+		CHECK(buffer.get_capacity() >= 100);
+		for (std::uint32_t i = 0; i < 100; ++i)
+			CHECK(buffer.read<Endian::Little, std::uint8_t>() == i);
+	}
+
+	SECTION("resize keeps data and zeroes new bytes") {
+		Buffer buffer{"\x01\x02"_bv};
+		buffer.resize(1);
+		buffer.resize(3);
+		CHECK(buffer.get_data() == "\x01\x00\x00"_bv);
+		buffer.resize(Buffer::InlineCapacity + 1);
+		CHECK(buffer.get_data().substr(0, 4) == "\x01\x00\x00\x00"_bv);
+		CHECK(buffer.get_data()[Buffer::InlineCapacity] == 0);
+	}
+
+	SECTION("copy and move") {
+		Buffer small{"\x01\x02"_bv};
+		Buffer large(Buffer::InlineCapacity * 2);
+		large.get_raw_data()[0] = 0x42;
+
+		Buffer small_copy = small;
+		Buffer large_copy = large;
+		CHECK(small_copy == small);
+		CHECK(large_copy == large);
+		CHECK(large_copy.get_raw_data() != large.get_raw_data());
+
+		Buffer small_moved = std::move(small);
+		const auto* large_data = large.get_raw_data();
+		Buffer large_moved = std::move(large);
+		CHECK(small_moved == small_copy);
+		CHECK(large_moved == large_copy);
+		CHECK(large_moved.get_raw_data() == large_data);
+		CHECK(small.get_size() == 0);
+		CHECK(large.get_size() == 0);
+
+		small_moved = large_moved;
+		CHECK(small_moved == large_copy);
+		large_moved = std::move(small_copy);
+		CHECK(large_moved.get_data() == "\x01\x02"_bv);
+	}
+
+	SECTION("geometric growth") {
+		Buffer buffer;
+		std::size_t reallocations = 0;
+		const auto* data = buffer.get_raw_data();
+		for (std::uint32_t i = 0; i < 4096; ++i)
+		{
+			buffer.write<Endian::Little, std::uint8_t>(static_cast<std::uint8_t>(i));
+			if (buffer.get_raw_data() != data)
+			{
+				data = buffer.get_raw_data();
+				++reallocations;
+			}
+		}
+
+		CHECK(buffer.get_size() == 4096);
+		CHECK(reallocations <= 7);
+	}
+
+	SECTION("write after resize overwrites") {
+		Buffer buffer;
+		buffer.write<Endian::Little, std::uint16_t>(0x1234);
+		buffer.resize(4);
+		buffer.write<Endian::Little, std::uint16_t>(0x5678);
+		CHECK(buffer.get_data() == "\x34\x12\x78\x56"_bv);
+	}
+
+	SECTION("write nt string") {
+		Buffer buffer;
+		buffer.write_nt_string("ab");
+		buffer.write_nt_string(std::string_view{"cde"}.substr(0, 2));
+		CHECK(buffer.get_data() == "ab\0cd\0"_bv);
+		CHECK(buffer.read_nt_string() == "ab");
+	}
+
+	SECTION("write array") {
+		Buffer buffer;
+		std::uint16_t values[] = {0x1234, 0x5678};
+		buffer.write_array<Endian::Big, std::uint16_t>(values);
+		buffer.write_array<Endian::Little, std::uint16_t>(values);
+		CHECK(buffer.get_data() == "\x12\x34\x56\x78\x34\x12\x78\x56"_bv);
+	}
+
+	SECTION("write vector of multiple int32 (big endian)") {
+		Buffer buffer;
+		buffer.write<Endian::Big, std::vector<std::uint32_t>>(std::vector<std::uint32_t>{0x01020304, 0x05060708});
+		CHECK(buffer.get_data() == "\x01\x02\x03\x04\x05\x06\x07\x08"_bv);
+	}
+
+	SECTION("read array") {
+		Buffer buffer{"\x12\x34\x56\x78\x9a"_bv};
+		std::uint16_t values[2] = {};
+		REQUIRE(buffer.read_array<Endian::Big, std::uint16_t>(values));
+		CHECK(values[0] == 0x1234);
+		CHECK(values[1] == 0x5678);
+		CHECK_FALSE(buffer.read_array<Endian::Big, std::uint16_t>(values));
+		CHECK(buffer.read<Endian::Big, std::uint8_t>() == 0x9a);
+	}
+
+	SECTION("read vector of multiple int16 (little endian)") {
+		Buffer buffer{"\x12\x34\x56\x78\x9a"_bv};
+		CHECK(buffer.read<Endian::Little, std::vector<std::uint16_t>>(2) == std::vector<std::uint16_t>{0x3412, 0x7856});
+	}
+
+	SECTION("read vector with not enough data") {
+		Buffer buffer{"\x12\x34\x56"_bv};
+		CHECK(buffer.read<Endian::Big, std::vector<std::uint16_t>>(4) == std::vector<std::uint16_t>{0x1234});
+		CHECK(buffer.read<Endian::Big, std::vector<std::uint16_t>>(4) == std::vector<std::uint16_t>{});
+	}
 }
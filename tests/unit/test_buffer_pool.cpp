@@ -0,0 +1,79 @@
+#include <memory>
+
+#include <catch2/catch.hpp>
+
+#include "buffer_pool.hpp"
+
+using namespace ccool;
+using namespace std::literals;
+
+TEST_CASE("Buffer pool tests", "utils") {
+	SECTION("small buffers are not pooled") {
+		auto pool = std::make_shared<BufferPool>();
+		auto buffer = pool->acquire(Buffer::InlineCapacity);
+		CHECK(buffer.get_size() == Buffer::InlineCapacity);
+		CHECK(buffer.get_capacity() == Buffer::InlineCapacity);
+
+		auto stats = pool->get_stats();
+		CHECK(stats.acquired == 1);
+		CHECK(stats.inlined == 1);
+		CHECK(stats.hits == 0);
+		CHECK(stats.allocations == 0);
+	}
+
+	SECTION("storage is reused") {
+		auto pool = std::make_shared<BufferPool>();
+		const std::uint8_t* data = nullptr;
+		{
+			auto buffer = pool->acquire(512);
+			CHECK(buffer.get_size() == 512);
+			data = buffer.get_raw_data();
+		}
+
+		for (int i = 0; i < 10; ++i)
+		{
+			auto buffer = pool->acquire(256);
+			CHECK(buffer.get_size() == 256);
+			CHECK(buffer.get_raw_data() == data);
+			CHECK(buffer.get_data().find_first_not_of(std::uint8_t{0}) == BytesView::npos);
+			buffer.get_raw_data()[0] = 0xFF;
+		}
+
+		auto stats = pool->get_stats();
+		CHECK(stats.acquired == 11);
+		CHECK(stats.inlined == 0);
+		CHECK(stats.hits == 10);
+		CHECK(stats.allocations == 1);
+	}
+
+	SECTION("storage is returned after move") {
+		auto pool = std::make_shared<BufferPool>();
+		{
+			Buffer moved;
+			{
+				auto buffer = pool->acquire(128);
+				moved = std::move(buffer);
+			}
+			CHECK(moved.get_size() == 128);
+			CHECK(pool->get_stats().allocations == 1);
+		}
+
+		pool->acquire(128);
+		CHECK(pool->get_stats().allocations == 1);
+	}
+
+	SECTION("copy") {
+		auto pool = std::make_shared<BufferPool>();
+		auto buffer = pool->acquire("\x01\x02\x03"_bv);
+		CHECK(buffer.get_data() == "\x01\x02\x03"_bv);
+		CHECK(buffer.read<Endian::Little, std::uint8_t>() == 1);
+	}
+
+	SECTION("buffers outlive the pool") {
+		auto pool = std::make_shared<BufferPool>();
+		auto buffer = pool->acquire(1024);
+		pool.reset();
+		buffer.resize(2048);
+		CHECK(buffer.get_size() == 2048);
+	}
+}
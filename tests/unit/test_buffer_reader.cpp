@@ -0,0 +1,47 @@
+#include <catch2/catch.hpp>
+
+#include "buffer_reader.hpp"
+
+using namespace ccool;
+using namespace std::literals;
+
+TEST_CASE("Buffer reader tests", "utils") {
+	SECTION("read integers") {
+		Buffer buffer{"\x12\x34\x56\x78\x9a\xbc\xde"_bv};
+		BufferReader<Endian::Big> reader(buffer.get_data());
+		CHECK(reader.read<std::uint8_t>() == 0x12);
+		CHECK(reader.read<std::uint16_t>() == 0x3456);
+		CHECK(reader.read<std::uint32_t>() == 0x789abcde);
+	}
+
+	SECTION("read little endian") {
+		Buffer buffer{"\x12\x34"_bv};
+		BufferReader<Endian::Little> reader(buffer.get_data());
+		CHECK(reader.read<std::uint16_t>() == 0x3412);
+	}
+
+	SECTION("read fixed point") {
+		Buffer buffer{"\x05\x04"_bv};
+		BufferReader<Endian::Little> reader(buffer.get_data());
+		CHECK(reader.read<FixedPoint<16>>() == FixedPoint<16>{4.5});
+	}
+
+	SECTION("skip") {
+		Buffer buffer{"\x12\x34\x56"_bv};
+		BufferReader<Endian::Big> reader(buffer.get_data());
+		reader.skip(2);
+		CHECK(reader.read<std::uint8_t>() == 0x56);
+	}
+
+	SECTION("read array") {
+		Buffer buffer{"\x01\x02\x03\x04\x05"_bv};
+		BufferReader<Endian::Big> reader(buffer.get_data());
+		std::uint8_t bytes[1];
+		std::uint16_t values[2];
+		reader.read_array<std::uint8_t>(bytes);
+		reader.read_array<std::uint16_t>(values);
+		CHECK(bytes[0] == 0x01);
+		CHECK(values[0] == 0x0203);
+		CHECK(values[1] == 0x0405);
+	}
+}
@@ -14,6 +14,9 @@ TEST_CASE("Conversion tests", "utils") {
 	CHECK(convert<int>("-123") == -123);
 	CHECK(convert<int>("-123"s) == -123);
 	CHECK(convert<int>("-123"sv) == -123);
+	CHECK(convert<int>("abc") == std::nullopt);
+	CHECK(convert<int>("12abc"s) == std::nullopt);
+	CHECK(convert<int>(""sv) == std::nullopt);
 	CHECK(convert<bool>("0") == false);
 	CHECK(convert<bool>("1") == true);
 	CHECK(convert<bool>("true") == true);
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <thread>
+
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <catch2/catch.hpp>
+
+#include "event_loop.hpp"
+
+using namespace ccool;
+using namespace std::literals;
+
+TEST_CASE("Event loop tests", "event_loop") {
+	SECTION("stop from the loop") {
+		EventLoop loop;
+		int runs = 0;
+		loop.post([&]() {
+			++runs;
+			loop.stop();
+		});
+		loop.run();
+		CHECK(runs == 1);
+	}
+
+	SECTION("tasks posted from other thread") {
+		EventLoop loop;
+		int runs = 0;
+		auto thread = std::thread([&]() {
+			for (int i = 0; i < 100; ++i)
+				loop.post([&]() { ++runs; });
+			loop.post([&]() { loop.stop(); });
+		});
+		loop.run();
+		thread.join();
+		CHECK(runs == 100);
+	}
+
+	SECTION("file descriptor") {
+		EventLoop loop;
+		int fds[2];
+		REQUIRE(::pipe(fds) == 0);
+
+		char received = 0;
+		loop.add_fd(fds[0], EPOLLIN, [&](std::uint32_t events) {
+			CHECK((events & EPOLLIN) != 0);
+			CHECK(::read(fds[0], &received, 1) == 1);
+			loop.remove_fd(fds[0]);
+			loop.stop();
+		});
+		CHECK(::write(fds[1], "x", 1) == 1);
+		loop.run();
+		CHECK(received == 'x');
+
+		::close(fds[0]);
+		::close(fds[1]);
+	}
+
+	SECTION("timer") {
+		EventLoop loop;
+		auto fired_at = Clock::time_point{};
+		Timer timer(loop, [&]() {
+			fired_at = Clock::now();
+			loop.stop();
+		});
+
+		auto armed_for = Clock::now() + 20ms;
+		timer.arm(armed_for);
+		loop.run();
+		CHECK(fired_at >= armed_for);
+	}
+
+	SECTION("disarmed timer") {
+		EventLoop loop;
+		bool fired = false;
+		Timer timer(loop, [&]() { fired = true; });
+		Timer stop_timer(loop, [&]() { loop.stop(); });
+
+		timer.arm(Clock::now() + 10ms);
+		timer.arm(Clock::time_point::max());
+		stop_timer.arm(Clock::now() + 30ms);
+		loop.run();
+		CHECK(!fired);
+	}
+
+	SECTION("signal") {
+		EventLoop loop;
+		int received = 0;
+		SignalWatcher watcher(loop, {SIGUSR1}, [&](int signum) {
+			received = signum;
+			loop.stop();
+		});
+
+		// Signal is blocked for this thread so it stays pending until the loop reads it
+		::pthread_kill(::pthread_self(), SIGUSR1);
+		loop.run();
+		CHECK(received == SIGUSR1);
+	}
+}
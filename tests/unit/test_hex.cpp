@@ -0,0 +1,108 @@
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "hex.hpp"
+
+using namespace ccool;
+
+namespace {
+
+std::vector<std::uint8_t> random_bytes(std::size_t size)
+{
+	std::mt19937 generator(size);
+	std::uniform_int_distribution<int> distribution(0, 255);
+
+	std::vector<std::uint8_t> result(size);
+	for (auto& byte : result)
+		byte = static_cast<std::uint8_t>(distribution(generator));
+	return result;
+}
+
+std::string encode(const std::vector<std::uint8_t>& data)
+{
+	std::string result(data.size() * 2, '\0');
+	hex_encode(data.data(), data.size(), result.data());
+	return result;
+}
+
+std::vector<std::uint8_t> decode(const std::string& hex)
+{
+	std::vector<std::uint8_t> result(hex.size() / 2);
+	hex_decode(hex.data(), result.size(), result.data());
+	return result;
+}
+
+} // namespace
+
+TEST_CASE("Hex tests", "utils") {
+	SECTION("encode") {
+		CHECK(encode({0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef}) == "0123456789abcdef");
+		CHECK(encode({}) == "");
+	}
+
+	SECTION("decode") {
+		CHECK(decode("0123456789abcdef") == std::vector<std::uint8_t>{0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef});
+		CHECK(decode("ABCDEF") == std::vector<std::uint8_t>{0xab, 0xcd, 0xef});
+	}
+
+	SECTION("same as scalar for all sizes") {
+		for (std::size_t size = 0; size < 200; ++size)
+		{
+			auto data = random_bytes(size);
+
+			std::string expected(size * 2, '\0');
+			hex_encode_scalar(data.data(), size, expected.data());
+			REQUIRE(encode(data) == expected);
+			REQUIRE(decode(expected) == data);
+
+			std::string upper = expected;
+			for (auto& c : upper)
+				c = static_cast<char>(std::toupper(c));
+			REQUIRE(decode(upper) == data);
+		}
+	}
+
+	SECTION("invalid characters") {
+		for (std::size_t pos : {0, 5, 31, 32, 63, 64, 100, 127})
+		{
+			for (char invalid : {'g', 'G', '/', ':', '@', '`', ' ', '\x10', '\xb0', '\xe1'})
+			{
+				std::string hex(128, 'a');
+				hex[pos] = invalid;
+				std::vector<std::uint8_t> data(64);
+				CHECK_THROWS_AS(hex_decode(hex.data(), data.size(), data.data()), std::runtime_error);
+			}
+		}
+	}
+}
+
+TEST_CASE("Hex benchmarks", "[!benchmark]") {
+	auto data = random_bytes(64 * 1024);
+	std::string hex(data.size() * 2, '\0');
+	hex_encode_scalar(data.data(), data.size(), hex.data());
+	std::vector<std::uint8_t> decoded(data.size());
+
+	BENCHMARK("encode (scalar)") {
+		hex_encode_scalar(data.data(), data.size(), hex.data());
+		return hex[0];
+	};
+
+	BENCHMARK("encode") {
+		hex_encode(data.data(), data.size(), hex.data());
+		return hex[0];
+	};
+
+	BENCHMARK("decode (scalar)") {
+		hex_decode_scalar(hex.data(), decoded.size(), decoded.data());
+		return decoded[0];
+	};
+
+	BENCHMARK("decode") {
+		hex_decode(hex.data(), decoded.size(), decoded.data());
+		return decoded[0];
+	};
+}
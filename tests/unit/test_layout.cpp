@@ -0,0 +1,38 @@
+#include <array>
+
+#include <catch2/catch.hpp>
+
+#include "layout.hpp"
+
+using namespace ccool;
+
+TEST_CASE("Layout tests", "utils") {
+	SECTION("store and load integers") {
+		std::array<std::uint8_t, 7> image = {};
+		store_field<Endian::Big, std::uint8_t>(image.data(), 0x12);
+		store_field<Endian::Big, std::uint16_t>(image.data() + 1, 0x3456);
+		store_field<Endian::Little, std::uint32_t>(image.data() + 3, 0x789abcde);
+		CHECK(image == std::array<std::uint8_t, 7>{0x12, 0x34, 0x56, 0xde, 0xbc, 0x9a, 0x78});
+
+		CHECK(load_field<Endian::Big, std::uint8_t>(image.data()) == 0x12);
+		CHECK(load_field<Endian::Big, std::uint16_t>(image.data() + 1) == 0x3456);
+		CHECK(load_field<Endian::Little, std::uint32_t>(image.data() + 3) == 0x789abcde);
+	}
+
+	SECTION("store and load fixed point") {
+		std::array<std::uint8_t, 2> image = {};
+		store_field<Endian::Little, FixedPoint<16>>(image.data(), FixedPoint<16>{4.5});
+		CHECK(image == std::array<std::uint8_t, 2>{0x05, 0x04});
+		CHECK(load_field<Endian::Little, FixedPoint<16>>(image.data()) == FixedPoint<16>{4.5});
+	}
+
+	SECTION("store and load arrays") {
+		std::array<std::uint8_t, 7> image = {};
+		store_array_field<Endian::Big, std::uint8_t>(image.data(), std::array<std::uint8_t, 3>{0x01, 0x02, 0x03});
+		store_array_field<Endian::Big, std::uint16_t>(image.data() + 3, std::array<std::uint16_t, 2>{0x0405, 0x0607});
+		CHECK(image == std::array<std::uint8_t, 7>{0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07});
+
+		CHECK(load_array_field<Endian::Big, std::uint8_t>(image.data(), 3) == std::vector<std::uint8_t>{0x01, 0x02, 0x03});
+		CHECK(load_array_field<Endian::Big, std::uint16_t>(image.data() + 3, 2) == std::vector<std::uint16_t>{0x0405, 0x0607});
+	}
+}
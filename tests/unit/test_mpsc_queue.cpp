@@ -0,0 +1,61 @@
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "mpsc_queue.hpp"
+
+using namespace ccool;
+
+TEST_CASE("MPSC queue tests", "utils") {
+	SECTION("empty queue") {
+		MpscQueue<int> queue;
+		CHECK(queue.pop() == std::nullopt);
+	}
+
+	SECTION("first in first out") {
+		MpscQueue<int> queue;
+		queue.push(1);
+		queue.push(2);
+		queue.push(3);
+		CHECK(queue.pop() == 1);
+		CHECK(queue.pop() == 2);
+		CHECK(queue.pop() == 3);
+		CHECK(queue.pop() == std::nullopt);
+	}
+
+	SECTION("multiple producers") {
+		constexpr int producer_count = 4;
+		constexpr int values_per_producer = 10000;
+
+		MpscQueue<int> queue;
+		std::vector<std::thread> producers;
+		for (int i = 0; i < producer_count; ++i)
+		{
+			producers.emplace_back([&queue, i]() {
+				for (int j = 0; j < values_per_producer; ++j)
+					queue.push(i * values_per_producer + j);
+			});
+		}
+
+		std::vector<int> last_values(producer_count, -1);
+		bool ordered = true;
+		int received = 0;
+		while (received < producer_count * values_per_producer)
+		{
+			if (auto value = queue.pop(); value)
+			{
+				auto producer = value.value() / values_per_producer;
+				ordered = ordered && value.value() > last_values[producer];
+				last_values[producer] = value.value();
+				++received;
+			}
+		}
+
+		for (auto& producer : producers)
+			producer.join();
+
+		CHECK(ordered);
+		CHECK(queue.pop() == std::nullopt);
+	}
+}
@@ -0,0 +1,101 @@
+#include <string>
+
+#include <catch2/catch.hpp>
+#include <ulocal/ulocal.hpp>
+
+using namespace std::literals;
+
+using RouteTable = ulocal::RouteTable<std::string>;
+using MatchResult = RouteTable::MatchResult;
+
+namespace {
+
+std::string match_action(const RouteTable& routes, std::string_view route, std::string_view method)
+{
+	ulocal::RouteParams params;
+	auto match = routes.match(route, method, params);
+	return match.result == MatchResult::Found ? **match.action : std::string{};
+}
+
+} // namespace
+
+TEST_CASE("Route table tests", "ulocal") {
+	RouteTable routes;
+	routes.add_route("/", std::initializer_list<std::string>{"GET"}, "root"s);
+	routes.add_route("/devices", std::initializer_list<std::string>{"GET"}, "devices"s);
+	routes.add_route("/devices/{id}/pump", std::initializer_list<std::string>{"GET", "POST"}, "pump"s);
+	routes.add_route("/devices/{id}/fans/{index}", std::initializer_list<std::string>{"GET"}, "fan"s);
+	routes.add_route("/devices/all/pump", std::initializer_list<std::string>{"POST"}, "all pumps"s);
+
+	SECTION("literal routes") {
+		CHECK(match_action(routes, "/", "GET") == "root");
+		CHECK(match_action(routes, "/devices", "GET") == "devices");
+		CHECK(match_action(routes, "/DEVICES", "get") == "devices");
+	}
+
+	SECTION("unknown routes") {
+		ulocal::RouteParams params;
+		CHECK(routes.match("/pump", "GET", params).result == MatchResult::NoRoute);
+		CHECK(routes.match("/devices/", "GET", params).result == MatchResult::NoRoute);
+		CHECK(routes.match("/devices/0", "GET", params).result == MatchResult::NoRoute);
+		CHECK(routes.match("/devices//pump", "GET", params).result == MatchResult::NoRoute);
+		CHECK(routes.match("/devices/0/pump/", "GET", params).result == MatchResult::NoRoute);
+		CHECK(routes.match("", "GET", params).result == MatchResult::NoRoute);
+	}
+
+	SECTION("unsupported method") {
+		ulocal::RouteParams params;
+		CHECK(routes.match("/devices", "POST", params).result == MatchResult::NoMethod);
+		CHECK(routes.match("/devices/0/fans/1", "DELETE", params).result == MatchResult::NoMethod);
+	}
+
+	SECTION("route parameters") {
+		std::string resource = "/devices/12/fans/3";
+		ulocal::RouteParams params;
+		auto match = routes.match(resource, "GET", params);
+		REQUIRE(match.result == MatchResult::Found);
+		CHECK(**match.action == "fan");
+		CHECK(params.size() == 2);
+		CHECK(params.get("id", resource) == "12");
+		CHECK(params.get("index", resource) == "3");
+		CHECK(params.get("name", resource) == std::nullopt);
+	}
+
+	SECTION("literal segment takes precedence over parameter") {
+		CHECK(match_action(routes, "/devices/all/pump", "POST") == "all pumps");
+		CHECK(match_action(routes, "/devices/all/pump", "GET") == "pump");
+		CHECK(match_action(routes, "/devices/1/pump", "POST") == "pump");
+	}
+
+	SECTION("parameters of abandoned match are dropped") {
+		routes.add_route("/devices/{id}/fans", std::initializer_list<std::string>{"GET"}, "fans"s);
+		std::string resource = "/devices/all/fans";
+		ulocal::RouteParams params;
+		auto match = routes.match(resource, "GET", params);
+		REQUIRE(match.result == MatchResult::Found);
+		CHECK(**match.action == "fans");
+		CHECK(params.size() == 1);
+		CHECK(params.get("id", resource) == "all");
+	}
+
+	SECTION("route can be replaced") {
+		routes.add_route("/devices", std::initializer_list<std::string>{"GET"}, "new devices"s);
+		CHECK(match_action(routes, "/devices", "GET") == "new devices");
+	}
+
+	SECTION("conflicting parameter names") {
+		CHECK_THROWS_AS(routes.add_route("/devices/{name}", std::initializer_list<std::string>{"GET"}, "device"s), std::runtime_error);
+	}
+
+	SECTION("request exposes route parameters") {
+		ulocal::HttpRequest request{"GET", "/devices/7/fans/1?max_age=100"};
+		ulocal::RouteParams params;
+		REQUIRE(routes.match(request.get_resource(), request.get_method(), params).result == MatchResult::Found);
+		request.set_route_params(params);
+
+		auto copy = request;
+		CHECK(copy.get_route_param("id") == "7");
+		CHECK(copy.get_route_param("index") == "1");
+		CHECK(copy.get_argument("max_age")->get_value() == "100");
+	}
+}
@@ -0,0 +1,91 @@
+#include <atomic>
+#include <future>
+#include <latch>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "single_flight.hpp"
+
+using namespace ccool;
+
+TEST_CASE("Single flight tests", "utils") {
+	SECTION("pending operation is shared") {
+		SingleFlight<int> flight;
+		std::promise<int> promise;
+		int started = 0;
+
+		auto start = [&]() {
+			++started;
+			return promise.get_future();
+		};
+
+		auto first = flight.run(start);
+		auto second = flight.run(start);
+		CHECK(started == 1);
+
+		promise.set_value(42);
+		CHECK(first.get() == 42);
+		CHECK(second.get() == 42);
+	}
+
+	SECTION("finished operation is started again") {
+		SingleFlight<int> flight;
+		int started = 0;
+
+		auto start = [&]() {
+			std::promise<int> promise;
+			promise.set_value(++started);
+			return promise.get_future();
+		};
+
+		CHECK(flight.run(start).get() == 1);
+		CHECK(flight.run(start).get() == 2);
+		CHECK(started == 2);
+	}
+
+	SECTION("error is shared") {
+		SingleFlight<void> flight;
+		std::promise<void> promise;
+
+		auto first = flight.run([&]() { return promise.get_future(); });
+		auto second = flight.run([&]() { return promise.get_future(); });
+
+		promise.set_exception(std::make_exception_ptr(std::runtime_error("failed")));
+		CHECK_THROWS_AS(first.get(), std::runtime_error);
+		CHECK_THROWS_AS(second.get(), std::runtime_error);
+	}
+
+	SECTION("concurrent callers") {
+		constexpr int caller_count = 8;
+
+		SingleFlight<int> flight;
+		std::promise<int> promise;
+		std::atomic<int> started = 0;
+		std::latch joined(caller_count);
+
+		std::vector<std::thread> callers;
+		std::vector<int> results(caller_count, 0);
+		for (int i = 0; i < caller_count; ++i)
+		{
+			callers.emplace_back([&, i]() {
+				auto result = flight.run([&]() {
+					++started;
+					return promise.get_future();
+				});
+				joined.count_down();
+				results[i] = result.get();
+			});
+		}
+
+		joined.wait();
+		promise.set_value(7);
+		for (auto& caller : callers)
+			caller.join();
+
+		CHECK(started == 1);
+		CHECK(results == std::vector<int>(caller_count, 7));
+	}
+}
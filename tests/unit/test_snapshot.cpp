@@ -0,0 +1,64 @@
+#include <memory>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <device.hpp>
+#include <protocols/snapshot_test.hpp>
+
+using namespace ccool;
+using namespace std::literals;
+
+namespace {
+
+class SnapshotDeviceInterface : public DeviceInterface
+{
+public:
+	virtual void bind() override {}
+
+	virtual std::uint32_t get_vendor_id() override { return 0; }
+	virtual std::uint32_t get_product_id() override { return 0; }
+	virtual std::string get_location() override { return "snapshot"; }
+
+	virtual void control(std::uint32_t, std::uint32_t, std::uint32_t) override { ++controls; }
+	virtual void send(std::uint8_t, const Buffer& data) override { sent.push_back(data); }
+	virtual Buffer recv(std::uint8_t) override { return Buffer{std::string{"b00000112201000200030004002005"}}; }
+
+	std::size_t controls = 0;
+	std::vector<Buffer> sent;
+};
+
+} // namespace
+
+TEST_CASE("Snapshot tests", "protocol") {
+	SECTION("generated layout builds snapshot") {
+		Buffer response{std::string{"b00000112201000200030004002005"}};
+		auto snapshot = SnapshotTest::ReadSnapshotLayout::get_snapshot(response.get_raw_data());
+		CHECK(snapshot.pump_rpm == 0x1122);
+		CHECK(snapshot.fan_count == 4);
+		CHECK(std::vector<std::uint16_t>(snapshot.get_fans_rpm().begin(), snapshot.get_fans_rpm().end()) == std::vector<std::uint16_t>{0x100, 0x200, 0x300, 0x400});
+		CHECK(snapshot.temperature == FixedPoint<16>{32.5});
+	}
+
+	SECTION("device reads snapshot with single message") {
+		auto device_interface = std::make_unique<SnapshotDeviceInterface>();
+		auto* interface = device_interface.get();
+		Device<SnapshotTest> device(std::move(device_interface), "Snapshot Test", 3, 1);
+
+		auto snapshot = device.read_snapshot();
+		CHECK(snapshot.pump_rpm == 0x1122);
+		CHECK(std::vector<std::uint16_t>(snapshot.get_fans_rpm().begin(), snapshot.get_fans_rpm().end()) == std::vector<std::uint16_t>{0x100, 0x200, 0x300});
+		CHECK(snapshot.temperature == FixedPoint<16>{32.5});
+
+		REQUIRE(interface->sent.size() == 1);
+		CHECK(interface->sent[0].get_data() == "\xb0"_bv);
+		CHECK(interface->controls == SnapshotTest::PreRequest.size() + SnapshotTest::PostResponse.size());
+	}
+
+	SECTION("fans not reported by message are zero") {
+		Device<SnapshotTest> device(std::make_unique<SnapshotDeviceInterface>(), "Snapshot Test", 6, 1);
+
+		auto snapshot = device.read_snapshot();
+		CHECK(std::vector<std::uint16_t>(snapshot.get_fans_rpm().begin(), snapshot.get_fans_rpm().end()) == std::vector<std::uint16_t>{0x100, 0x200, 0x300, 0x400, 0, 0});
+	}
+}
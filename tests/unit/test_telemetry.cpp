@@ -0,0 +1,63 @@
+#include <chrono>
+
+#include <catch2/catch.hpp>
+
+#include "telemetry.hpp"
+
+using namespace ccool;
+using namespace std::literals;
+
+TEST_CASE("Telemetry tests", "telemetry") {
+	SECTION("empty value") {
+		CachedValue<int> value;
+		CHECK(value.get() == std::nullopt);
+	}
+
+	SECTION("updated value") {
+		CachedValue<int> value;
+		value.update(42);
+		CHECK(value.get() == 42);
+		CHECK(value.get(1h) == 42);
+	}
+
+	SECTION("too old value") {
+		CachedValue<int> value;
+		value.update(42, Clock::now() - 2s);
+		CHECK(value.get() == 42);
+		CHECK(value.get(1s) == std::nullopt);
+	}
+
+	SECTION("sub-millisecond old value") {
+		CachedValue<int> value;
+		value.update(42, Clock::now() - 100us);
+		CHECK(value.get(0ms) == std::nullopt);
+		CHECK(value.get(1ms) == 42);
+		CHECK(value.get(std::chrono::milliseconds::max()) == 42);
+	}
+
+	SECTION("reset value") {
+		CachedValue<int> value;
+		value.update(42);
+		value.reset();
+		CHECK(value.get() == std::nullopt);
+	}
+
+	SECTION("get or update with fresh value") {
+		CachedValue<int> value;
+		value.update(42);
+		CHECK(value.get_or_update(1s, []() { return 10; }) == 42);
+	}
+
+	SECTION("get or update with old value") {
+		CachedValue<int> value;
+		value.update(42, Clock::now() - 2s);
+		CHECK(value.get_or_update(1s, []() { return 10; }) == 10);
+		CHECK(value.get() == 10);
+	}
+
+	SECTION("get or update without value") {
+		CachedValue<int> value;
+		CHECK(value.get_or_update(0ms, []() { return 10; }) == 10);
+		CHECK(value.get() == 10);
+	}
+}
@@ -0,0 +1,116 @@
+#include <chrono>
+
+#include <catch2/catch.hpp>
+
+#include "telemetry_history.hpp"
+
+using namespace ccool;
+using namespace std::literals;
+
+namespace {
+
+SystemClock::time_point at(std::int64_t seconds)
+{
+	return SystemClock::time_point{std::chrono::seconds{seconds}};
+}
+
+} // namespace
+
+TEST_CASE("Telemetry history tests", "telemetry") {
+	SECTION("empty series") {
+		TimeSeries series;
+		auto points = series.query(0, 1);
+		REQUIRE(points);
+		CHECK(points->empty());
+	}
+
+	SECTION("values within single second are aggregated") {
+		TimeSeries series;
+		series.add(10.0, at(100));
+		series.add(30.0, at(100) + 500ms);
+		series.add(20.0, at(101));
+
+		auto points = series.query(0, 1);
+		REQUIRE(points);
+		REQUIRE(points->size() == 2);
+		CHECK(points->at(0).time == 100);
+		CHECK(points->at(0).min == 10.0);
+		CHECK(points->at(0).max == 30.0);
+		CHECK(points->at(0).avg == 20.0);
+		CHECK(points->at(1).time == 101);
+		CHECK(points->at(1).avg == 20.0);
+	}
+
+	SECTION("coarser tier") {
+		TimeSeries series;
+		for (std::int64_t i = 0; i < 180; ++i)
+			series.add(static_cast<double>(i), at(i));
+
+		auto points = series.query(0, 60);
+		REQUIRE(points);
+		REQUIRE(points->size() == 3);
+		CHECK(points->at(1).time == 60);
+		CHECK(points->at(1).min == 60.0);
+		CHECK(points->at(1).max == 119.0);
+		CHECK(points->at(1).avg == 89.5);
+	}
+
+	SECTION("step is aggregated from finer tier") {
+		TimeSeries series;
+		for (std::int64_t i = 0; i < 20; ++i)
+			series.add(static_cast<double>(i), at(i));
+
+		auto points = series.query(0, 10);
+		REQUIRE(points);
+		REQUIRE(points->size() == 2);
+		CHECK(points->at(0).min == 0.0);
+		CHECK(points->at(0).max == 9.0);
+		CHECK(points->at(1).time == 10);
+		CHECK(points->at(1).avg == 14.5);
+	}
+
+	SECTION("from") {
+		TimeSeries series;
+		for (std::int64_t i = 0; i < 10; ++i)
+			series.add(static_cast<double>(i), at(i));
+
+		auto points = series.query(5, 1);
+		REQUIRE(points);
+		REQUIRE(points->size() == 5);
+		CHECK(points->front().time == 5);
+	}
+
+	SECTION("ring buffer overwrites oldest values") {
+		TimeSeries series;
+		auto capacity = static_cast<std::int64_t>(TimeSeries::Tiers[0].capacity);
+		for (std::int64_t i = 0; i < capacity + 10; ++i)
+			series.add(static_cast<double>(i), at(i));
+
+		auto points = series.query(0, 1);
+		REQUIRE(points);
+		REQUIRE(points->size() == static_cast<std::size_t>(capacity));
+		CHECK(points->front().time == 10);
+		CHECK(points->back().time == capacity + 9);
+	}
+
+	SECTION("invalid step") {
+		TimeSeries series;
+		CHECK(series.query(0, 0) == std::nullopt);
+		CHECK(series.query(0, -1) == std::nullopt);
+	}
+
+	SECTION("sensors") {
+		TelemetryHistory history(2);
+		history.record_fans_rpm({1000, 2000}, at(0));
+		CHECK(history.get_series("pump") != nullptr);
+		CHECK(history.get_series("temperature") != nullptr);
+		CHECK(history.get_series("fan2") == nullptr);
+		CHECK(history.get_series("unknown") == nullptr);
+
+		REQUIRE(history.get_series("fan1") != nullptr);
+		auto points = history.get_series("fan1")->query(0, 1);
+		REQUIRE(points);
+		REQUIRE(points->size() == 1);
+		CHECK(points->front().avg == 2000.0);
+	}
+}
@@ -0,0 +1,64 @@
+#include <atomic>
+#include <latch>
+#include <mutex>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "worker_pool.hpp"
+
+using namespace ccool;
+
+TEST_CASE("Worker pool tests", "utils") {
+	SECTION("submitted tasks are run") {
+		std::latch done(3);
+		std::atomic<int> runs = 0;
+		WorkerPool pool(1);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			pool.submit([&]() {
+				++runs;
+				done.count_down();
+			});
+		}
+
+		done.wait();
+		CHECK(runs == 3);
+	}
+
+	SECTION("tasks run in parallel") {
+		// Each task waits for the others so this only finishes if all of them run at once
+		std::latch all_started(4);
+		std::latch done(4);
+		WorkerPool pool(4);
+
+		for (int i = 0; i < 4; ++i)
+		{
+			pool.submit([&]() {
+				all_started.arrive_and_wait();
+				done.count_down();
+			});
+		}
+
+		done.wait();
+	}
+
+	SECTION("queued tasks are finished on destruction") {
+		std::mutex mutex;
+		std::vector<int> order;
+
+		{
+			WorkerPool pool(1);
+			for (int i = 0; i < 5; ++i)
+			{
+				pool.submit([&, i]() {
+					std::lock_guard lock(mutex);
+					order.push_back(i);
+				});
+			}
+		}
+
+		CHECK(order == std::vector<int>{0, 1, 2, 3, 4});
+	}
+}
@@ -53,9 +53,10 @@ def spec_type_to_cpp_type(type_name: str, allow_ref=False):
 
     if is_array:
         array_size = int(type_name[end_pos+1:-1])
-        result = f"std::vector<{result}>"
         if allow_ref:
-            result = f"const {result}&"
+            result = f"std::span<const {result}>"
+        else:
+            result = f"std::vector<{result}>"
 
     return result
 
@@ -109,64 +110,198 @@ def arg_precondition(request_name: str, arg: dict):
 )
 
 
-def to_buffer_write(arg):
-    return "buffer.write<endian, {}>({});".format(spec_type_to_cpp_type(arg["type"]), arg["name"])
+def spec_array_size(type_name: str):
+    end_pos = type_name.find("[")
+    return int(type_name[end_pos+1:-1])
+
+
+def spec_array_element_type(type_name: str):
+    return type_name[:type_name.find("[")]
+
+
+def fields_with_offsets(fields, start_offset: int):
+    offset = start_offset
+    for field in fields:
+        yield field, offset
+        offset += spec_type_size(field["type"])
+
+
+def opcode_image(opcode: int, opcode_size: int, endian: str):
+    return list(opcode.to_bytes(opcode_size, byteorder="big" if endian == "big" else "little"))
+
+
+def field_setter(field: dict, offset: int):
+    if spec_type_is_array(field["type"]):
+        store = "store_array_field<endian, {}>(request.data() + {}, value);".format(spec_type_to_cpp_type(spec_array_element_type(field["type"])), offset)
+    else:
+        store = "store_field<endian, {}>(request.data() + {}, value);".format(spec_type_to_cpp_type(field["type"]), offset)
+
+    return "static void set_{name}(RequestImageType& request, {arg_type} value) {{ {store} }}".format(
+        name=field["name"],
+        arg_type=spec_type_to_cpp_type(field["type"], allow_ref=True),
+        store=store
+    )
+
+
+def field_getter(field: dict, offset: int):
+    if spec_type_is_array(field["type"]):
+        load = "load_array_field<endian, {}>(response + {}, {})".format(
+            spec_type_to_cpp_type(spec_array_element_type(field["type"])),
+            offset,
+            spec_array_size(field["type"])
+        )
+    else:
+        load = "load_field<endian, {}>(response + {})".format(spec_type_to_cpp_type(field["type"]), offset)
+
+    return "static {type} get_{name}(const std::uint8_t* response) {{ return {load}; }}".format(
+        type=spec_type_to_cpp_type(field["type"]),
+        name=field["name"],
+        load=load
+    )
+
+
+def snapshot_builder(message: dict, opcode_size: int):
+    # Message reading all sensors at once maps its response fields to the members of SensorSnapshot
+    snapshot = message.get("snapshot")
+    if snapshot is None:
+        return None
+
+    if message["name"] != "read_snapshot":
+        raise ValueError("Only 'read_snapshot' message can have 'snapshot' mapping, found it in '{}'".format(message["name"]))
 
+    fields = {field["name"]: (field, offset) for field, offset in fields_with_offsets(message["response"] or [], opcode_size)}
+    fans_field, fans_offset = fields[snapshot["fans_rpm"]]
+    if not spec_type_is_array(fans_field["type"]) or spec_array_element_type(fans_field["type"]) != "u16":
+        raise ValueError("Field '{}' mapped to 'fans_rpm' of '{}' needs to be array of u16".format(fans_field["name"], message["name"]))
 
-def to_buffer_read(attr, create_var):
-    return "{}response.read<endian, {}>().value();".format("auto result_{} = ".format(attr["name"]) if create_var else "", spec_type_to_cpp_type(attr["type"]))
+    return """static SensorSnapshot get_snapshot(const std::uint8_t* response)
+{{
+\tstatic_assert({fan_count} <= SensorSnapshot::MaxFans, "Response of {request_name} has more fans than SensorSnapshot can hold");
+
+\tSensorSnapshot result;
+\tresult.pump_rpm = get_{pump_rpm}(response);
+\tresult.fan_count = {fan_count};
+\tload_array_field<endian, std::uint16_t>(response + {fans_offset}, std::span{{result.fans_rpm.data(), {fan_count}}});
+\tresult.temperature = get_{temperature}(response);
+\treturn result;
+}}""".format(
+        request_name=message["name"],
+        pump_rpm=fields[snapshot["pump_rpm"]][0]["name"],
+        fan_count=spec_array_size(fans_field["type"]),
+        fans_offset=fans_offset,
+        temperature=fields[snapshot["temperature"]][0]["name"]
+    )
 
 
-def message_to_method_declaration(message):
+def message_to_layout_struct(message: dict, protocol_spec: dict):
     request = message["request"] or []
     response = message["response"] or []
-    args = ["std::uint8_t endpoint"] + [arg_to_cpp_arg(arg) for arg in request]
+    opcode_size = spec_type_size(protocol_spec["opcode"])
+    request_size = opcode_size + sum([spec_type_size(arg["type"]) for arg in request])
+    response_size = opcode_size + sum([spec_type_size(attr["type"]) for attr in response])
+    request_image = opcode_image(message["opcode"], opcode_size, protocol_spec["endian"])
+    setters = [field_setter(field, offset) for field, offset in fields_with_offsets(request, opcode_size)]
     preconditions = list(filter(lambda pc: pc is not None, [arg_precondition(message["name"], arg) for arg in request]))
-    buffer_writes = [to_buffer_write(arg) for arg in request]
-    buffer_reads = [to_buffer_read(attr, attr["name"] in message.get("returns", [])) for attr in response]
-    response_size = 1 + sum([spec_type_size(attr["type"]) for attr in response])
-    response_type = RETURN_TYPES.get(message["name"], "void")
-    return_values = ["result_{}".format(attr) for attr in message.get("returns", [])]
-    if len(return_values) == 0:
+    request_writes = ["set_{0}(request, {0});".format(arg["name"]) for arg in request]
+    encode = """static RequestImageType encode({args})
+{{
+{preconditions}\tauto request = RequestImage;
+{request_writes}
+\treturn request;
+}}""".format(
+        args=", ".join([arg_to_cpp_arg(arg) for arg in request]),
+        preconditions="".join([precondition + "\n\n" for precondition in preconditions]),
+        request_writes=textwrap.indent("\n".join(request_writes), "\t")
+    ) if request else None
+    getters = ["static OpcodeType get_opcode(const std::uint8_t* response) { return load_field<endian, OpcodeType>(response); }"]
+    getters += [field_getter(field, offset) for field, offset in fields_with_offsets(response, opcode_size)]
+    snapshot = snapshot_builder(message, opcode_size)
+    return """struct {layout_name}
+{{
+\tstatic constexpr std::size_t RequestSize = {request_size};
+\tstatic constexpr std::size_t ResponseSize = {response_size};
+\tstatic_assert(RequestSize <= Mtu, "Request of {request_name} does not fit into endpoint MTU");
+\tstatic_assert(ResponseSize <= Mtu, "Response of {request_name} does not fit into endpoint MTU");
+
+\tusing RequestImageType = std::array<std::uint8_t, RequestSize>;
+\tstatic constexpr RequestImageType RequestImage = {{{request_image}}};
+
+{accessors}
+}};
+""".format(
+        layout_name=snake_case_to_camel_case(message["name"]) + "Layout",
+        request_name=message["name"],
+        request_size=request_size,
+        response_size=response_size,
+        request_image=", ".join([f"{byte:#04x}" for byte in request_image]),
+        accessors=textwrap.indent("\n\n".join(filter(None, ["\n".join(setters), "\n".join(getters), snapshot, encode])), "\t")
+    )
+
+
+def message_to_method_declaration(message: dict):
+    request = message["request"] or []
+    layout_name = snake_case_to_camel_case(message["name"]) + "Layout"
+    response_type = "SensorSnapshot" if "snapshot" in message else RETURN_TYPES.get(message["name"], "void")
+    return_values = ["Layout::get_{}(data)".format(attr) for attr in message.get("returns", [])]
+    if "snapshot" in message:
+        return_values = "Layout::get_snapshot(data)"
+    elif len(return_values) == 0:
         return_values = ""
     elif len(return_values) == 1:
         return_values = return_values[0]
     else:
         return_values = "{{{}}}".format(", ".join(return_values))
-    return """virtual {response_type} {request_name}({args}) override
+
+    # Messages with arguments can also be sent with already encoded request image
+    # so the same image can be reused for multiple messages.
+    if request:
+        encoding_method = """{response_type} {request_name}({args})
 {{
-{preconditions}
+\treturn {request_name}(endpoint, {layout_name}::encode({arg_names}));
+}}
 
-\tBuffer buffer;
-\tbuffer.write<endian, OpcodeType>({opcode:#04x});
-{buffer_writes}
+""".format(
+            response_type=response_type,
+            request_name=message["name"],
+            layout_name=layout_name,
+            args=", ".join(["std::uint8_t endpoint"] + [arg_to_cpp_arg(arg) for arg in request]),
+            arg_names=", ".join([arg["name"] for arg in request])
+        )
+        args = f"std::uint8_t endpoint, const {layout_name}::RequestImageType& request"
+        request_image = "request"
+    else:
+        encoding_method = ""
+        args = "std::uint8_t endpoint"
+        request_image = "Layout::RequestImage"
+
+    return """{encoding_method}{response_type} {request_name}({args})
+{{
+\tusing Layout = {layout_name};
 
-\tauto response = send(endpoint, buffer);
-\tif (response.get_size() != {response_size})
+\tauto response = send(endpoint, Buffer{{{request_image}.data(), {request_image}.size()}});
+\tif (response.get_size() != Layout::ResponseSize)
 \t{{
-\t\tspdlog::error("{request_name}: Obtained response with unexpected size '{{}}' while '{response_size}' was expected", response.get_size());
+\t\tspdlog::error("{request_name}: Obtained response with unexpected size '{{}}' while '{{}}' was expected", response.get_size(), Layout::ResponseSize);
 \t\tthrow std::runtime_error("Invalid response");
 \t}}
 
-\tauto opcode = response.read<endian, OpcodeType>().value();
-\tif (opcode != {opcode:#04x})
+\tconst auto* data = response.get_raw_data();
+\tif (auto opcode = Layout::get_opcode(data); opcode != {opcode:#04x})
 \t{{
 \t\tspdlog::error("{request_name}: Obtained response with opcode '{{:#04x}}' while '{opcode:#04x}' was expected", opcode);
 \t\tthrow std::runtime_error("Invalid response");
 \t}}
 
-{buffer_reads}
 \treturn {return_values};
 }}
 """.format(
+        encoding_method=encoding_method,
         response_type=response_type,
         request_name=message["name"],
-        args=", ".join(args),
-        preconditions="\n\n".join(preconditions) or "",
-        buffer_writes=textwrap.indent("\n".join(buffer_writes), "\t"),
+        layout_name=layout_name,
+        args=args,
+        request_image=request_image,
         opcode=message["opcode"],
-        response_size=response_size,
-        buffer_reads=textwrap.indent("\n".join(buffer_reads), "\t"),
         return_values=return_values
     )
 
@@ -179,11 +314,13 @@ def device_spec_to_cpp_class(device_spec: dict):
 
 namespace ccool {{
 
-class {class_name} : public Device<{protocol_type_name}>
+class {class_name} final : public Device<{protocol_type_name}>
 {{
 public:
 \t{class_name}(std::unique_ptr<DeviceInterface>&& device_interface) : Device(std::move(device_interface), "{device_name}", {fan_count}, {endpoint}) {{}}
 \tvirtual ~{class_name}() = default;
+
+\tstatic_assert({fan_count} <= SensorSnapshot::MaxFans, "{device_name} has more fans than SensorSnapshot can hold");
 }};
 
 }} // namespace ccool""".format(
@@ -196,34 +333,48 @@ public:
     )
 
 
+def action_to_control_request(action: dict):
+    if action["method"] != "control":
+        raise ValueError("Unsupported action '{}', only 'control' actions are supported".format(action["method"]))
+    return "{{{}}}".format(", ".join([f"{arg:#04x}" for arg in action["args"]]))
+
+
 def protocol_spec_to_cpp_class(protocol_spec: dict):
+    layouts = [message_to_layout_struct(msg, protocol_spec) for msg in protocol_spec["messages"]]
     messages = [message_to_method_declaration(msg) for msg in protocol_spec["messages"]]
-    pre_request = ["_device_interface->{}({});".format(action["method"], ", ".join([f"{arg:#04x}" for arg in action["args"]])) for action in protocol_spec["pre_request"]]
-    post_response = ["_device_interface->{}({});".format(action["method"], ", ".join([f"{arg:#04x}" for arg in action["args"]])) for action in protocol_spec["post_response"]]
+    pre_request = [action_to_control_request(action) for action in protocol_spec.get("pre_request") or []]
+    post_response = [action_to_control_request(action) for action in protocol_spec.get("post_response") or []]
     return """#pragma once
 
+#include <array>
+#include <span>
+
 #include <spdlog/spdlog.h>
 
 #include <endian.hpp>
+#include <layout.hpp>
 #include <protocol.hpp>
 
 namespace ccool {{
 
-class {class_name} : public Protocol<{endian}, {opcode_type}>
+class {class_name} final : public Protocol<{class_name}, {endian}, {opcode_type}>
 {{
 public:
-\t{class_name}(DeviceInterface* device_interface) : Protocol(device_interface, "{protocol_name}") {{}}
-\tvirtual ~{class_name}() = default;
+\t// Largest message which fits into single transfer
+\tstatic constexpr std::size_t Mtu = {mtu};
 
-\tvirtual void pre_request() override
-\t{{
+{layouts}
+\tstatic constexpr std::array<ControlRequest, {pre_request_count}> PreRequest = {{{{
 {pre_request}
-\t}}
+\t}}}};
 
-\tvirtual void post_response() override
-\t{{
+\tstatic constexpr std::array<ControlRequest, {post_response_count}> PostResponse = {{{{
 {post_response}
-\t}}
+\t}}}};
+
+\tstatic constexpr bool SupportsSessions = {supports_sessions};
+
+\t{class_name}(DeviceInterface* device_interface) : Protocol(device_interface, "{protocol_name}") {{}}
 
 {messages}
 }};
@@ -233,9 +384,14 @@ public:
         protocol_name=protocol_spec["name"],
         endian=spec_endian_to_cpp_endian(protocol_spec["endian"]),
         opcode_type=spec_type_to_cpp_type(protocol_spec["opcode"]),
+        mtu=protocol_spec.get("mtu", 64),
+        layouts=textwrap.indent("\n".join(layouts), "\t"),
         messages=textwrap.indent("\n".join(messages), "\t"),
-        pre_request=textwrap.indent("\n".join(pre_request), "\t\t"),
-        post_response=textwrap.indent("\n".join(post_response), "\t\t")
+        pre_request=textwrap.indent(",\n".join(pre_request), "\t\t"),
+        pre_request_count=len(pre_request),
+        post_response=textwrap.indent(",\n".join(post_response), "\t\t"),
+        post_response_count=len(post_response),
+        supports_sessions="true" if protocol_spec.get("sessions", False) else "false"
     )
 
 
@@ -284,8 +440,8 @@ def main():
     devices_dest_dir = Path(sys.argv[2]) / "devices"
     protocols_dest_dir = Path(sys.argv[2]) / "protocols"
 
-    Path(devices_dest_dir).mkdir(exist_ok=True)
-    Path(protocols_dest_dir).mkdir(exist_ok=True)
+    Path(devices_dest_dir).mkdir(parents=True, exist_ok=True)
+    Path(protocols_dest_dir).mkdir(parents=True, exist_ok=True)
 
     device_spec_files = yamls_in_dir(devices_dir)
     protocol_spec_files = yamls_in_dir(protocols_dir)
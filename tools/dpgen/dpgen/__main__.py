@@ -0,0 +1,4 @@
+from dpgen import main
+
+
+main()